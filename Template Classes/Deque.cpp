@@ -1,16 +1,62 @@
 #include <cstddef>
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <iterator>
+#include <utility>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
-
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <type_traits>
+
+// Elements live in fixed-size chunks that are never moved; only the map of
+// chunk pointers is reallocated when one of the ends runs out of room.
+// A chunk is allocated iff it holds at least one element.
 template <typename T>
 class Deque {
 private:
-    std::vector<T> head, tail;
+    static constexpr size_t kChunkSize = sizeof(T) <= 256 ? 4096 / sizeof(T) : 16;
+
+    std::vector<T*> chunks;
+    T* spare = nullptr;  // last released chunk, reused by the next push
+    size_t first = 0;  // slot index of Front() counted from the start of chunks[0]
+    size_t count = 0;
+
+    T& Slot(size_t pos) const;
+
+    T* AcquireChunk();
+
+    void ReleaseChunk(size_t node);
+
+    void ReallocateMap(size_t extra = 1);
+
+    void ReserveBack(size_t n);
+
+    void ReserveFront(size_t n);
 
 public:
+    template <bool IsConst>
+    class Iterator;
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    Deque() = default;
+
+    Deque(const Deque& other);
+
+    Deque(Deque&& other) noexcept;
+
+    Deque& operator = (Deque other) noexcept;
+
+    ~Deque();
+
+    void Swap(Deque& other) noexcept;
+
     bool Empty() const;
 
     size_t Size() const;
@@ -35,9 +81,208 @@ public:
 
     void PushFront(const T& elem);
 
+    void PushFront(T&& elem);
+
     void PushBack(const T& elem);
+
+    void PushBack(T&& elem);
+
+    template <typename... Args>
+    T& EmplaceFront(Args&&... args);
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args);
+
+    // Both construct from *it, so pass std::move_iterator to move elements in.
+    // The map is grown at most once for forward iterators.
+    template <typename Iter>
+    void Append(Iter from, Iter to);
+
+    template <typename BidirIt>
+    void Prepend(BidirIt from, BidirIt to);  // keeps the order of [from, to)
+
+    void PopFront();  // throws std::out_of_range on empty deque
+
+    void PopBack();  // throws std::out_of_range on empty deque
+
+    iterator begin();
+
+    iterator end();
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
 };
 
+// Walks one chunk with a plain pointer and only touches the map when it
+// crosses a chunk boundary. The map always keeps a slot past the last
+// occupied chunk, so end() never points outside of it.
+template <typename T>
+template <bool IsConst>
+class Deque<T>::Iterator {
+private:
+    friend class Deque<T>;
+    friend class Iterator<!IsConst>;
+
+    T* const* node = nullptr;
+    T* cur = nullptr;
+
+    Iterator(T* const* node, size_t offset):
+        node(node),
+        cur(node ? *node + offset : nullptr) {}
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const T*, T*>;
+    using reference = std::conditional_t<IsConst, const T&, T&>;
+
+    Iterator() = default;
+
+    operator Iterator<true>() const {
+        Iterator<true> it;
+        it.node = node;
+        it.cur = cur;
+        return it;
+    }
+
+    reference operator * () const {
+        return *cur;
+    }
+
+    pointer operator -> () const {
+        return cur;
+    }
+
+    Iterator& operator ++ () {
+        if (++cur == *node + kChunkSize) {
+            cur = *++node;
+        }
+        return *this;
+    }
+
+    Iterator operator ++ (int) {
+        auto tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    Iterator& operator -- () {
+        if (cur == *node) {
+            cur = *--node + kChunkSize;
+        }
+        --cur;
+        return *this;
+    }
+
+    Iterator operator -- (int) {
+        auto tmp(*this);
+        --*this;
+        return tmp;
+    }
+
+    bool operator == (const Iterator& other) const {
+        return cur == other.cur;
+    }
+
+    bool operator != (const Iterator& other) const {
+        return cur != other.cur;
+    }
+};
+
+template<typename T>
+T& Deque<T>::Slot(size_t pos) const {
+    return chunks[pos / kChunkSize][pos % kChunkSize];
+}
+
+template<typename T>
+T* Deque<T>::AcquireChunk() {
+    if (spare != nullptr) {
+        return std::exchange(spare, nullptr);
+    }
+    return std::allocator<T>().allocate(kChunkSize);
+}
+
+template<typename T>
+void Deque<T>::ReleaseChunk(size_t node) {
+    if (spare == nullptr) {
+        spare = chunks[node];
+    } else {
+        std::allocator<T>().deallocate(chunks[node], kChunkSize);
+    }
+    chunks[node] = nullptr;
+}
+
+// Recenters the occupied chunks leaving at least `extra` free chunks on each
+// side, growing the map only when it is more than about half full, so a deque
+// used as a FIFO keeps a map of constant size.
+template<typename T>
+void Deque<T>::ReallocateMap(size_t extra) {
+    size_t used = count ? (first + count - 1) / kChunkSize - first / kChunkSize + 1 : 0;
+    size_t new_size = chunks.size();
+    if (new_size < 2 * (used + extra) + 2) {
+        new_size = std::max({2 * chunks.size(), 2 * (used + extra) + 2, size_t{8}});
+    }
+    std::vector<T*> new_chunks(new_size, nullptr);
+    size_t new_node = (new_size - used) / 2;
+    std::copy_n(chunks.begin() + (used ? first / kChunkSize : 0), used, new_chunks.begin() + new_node);
+    chunks.swap(new_chunks);
+    first = new_node * kChunkSize + (used ? first % kChunkSize : 0);
+}
+
+template<typename T>
+void Deque<T>::ReserveBack(size_t n) {
+    if ((first + count + n) / kChunkSize + 1 >= chunks.size()) {
+        // The new elements first fill the rest of a partially used last chunk.
+        size_t tail = count ? (first + count) % kChunkSize : 0;
+        this->ReallocateMap((tail + n + kChunkSize - 1) / kChunkSize + 1);
+    }
+}
+
+template<typename T>
+void Deque<T>::ReserveFront(size_t n) {
+    if (first < n || chunks.empty()) {
+        this->ReallocateMap(n / kChunkSize + 1);
+    }
+}
+
+// Copies into a local deque first: if a copy throws, its destructor frees
+// what was built so far, while ours would never run.
+template<typename T>
+Deque<T>::Deque(const Deque& other) {
+    Deque tmp;
+    tmp.Append(other.begin(), other.end());
+    this->Swap(tmp);
+}
+
+template<typename T>
+Deque<T>::Deque(Deque&& other) noexcept {
+    this->Swap(other);
+}
+
+template<typename T>
+Deque<T>& Deque<T>::operator=(Deque other) noexcept {
+    this->Swap(other);
+    return *this;
+}
+
+template<typename T>
+Deque<T>::~Deque() {
+    this->Clear();
+    if (spare != nullptr) {
+        std::allocator<T>().deallocate(spare, kChunkSize);
+    }
+}
+
+template<typename T>
+void Deque<T>::Swap(Deque& other) noexcept {
+    chunks.swap(other.chunks);
+    std::swap(spare, other.spare);
+    std::swap(first, other.first);
+    std::swap(count, other.count);
+}
+
 template<typename T>
 bool Deque<T>::Empty() const {
     return !this->Size();
@@ -45,71 +290,220 @@ bool Deque<T>::Empty() const {
 
 template<typename T>
 size_t Deque<T>::Size() const {
-    return head.size() + tail.size();
+    return count;
 }
 
 template<typename T>
 void Deque<T>::Clear() {
-    head.clear();
-    tail.clear();
+    while (count) {
+        this->PopBack();
+    }
 }
 
 template<typename T>
 const T& Deque<T>::operator[](size_t i) const {
-    return (i >= tail.size() ? head[i - tail.size()] : tail[tail.size() - i - 1]);
+    return Slot(first + i);
 }
 
 template<typename T>
 T& Deque<T>::operator[](size_t i) {
-    return (i >= tail.size() ? head[i - tail.size()] : tail[tail.size() - i - 1]);
+    return Slot(first + i);
 }
 
 template<typename T>
 const T& Deque<T>::At(size_t i) const {
-    if (i >= this->Size() || i < 0) {
+    if (i >= this->Size()) {
         throw std::out_of_range("");
     }
-    return (i >= tail.size() ? head[i - tail.size()] : tail[i]);
+    return Slot(first + i);
 }
 
 template<typename T>
 T& Deque<T>::At(size_t i) {
-    if (i >= this->Size() || i < 0) {
+    if (i >= this->Size()) {
         throw std::out_of_range("");
     }
-    return (i >= tail.size() ? head[i - tail.size()] : tail[i]);
+    return Slot(first + i);
 }
 
 template<typename T>
 const T& Deque<T>::Front() const {
-    return (tail.size() ? tail.back() : head[0]);
+    return Slot(first);
 }
 
 template<typename T>
 T& Deque<T>::Front() {
-    return (tail.size() ? tail.back() : head[0]);
+    return Slot(first);
 }
 
 template<typename T>
 const T& Deque<T>::Back() const {
-    return (head.size() ? head.back() : tail[0]);
+    return Slot(first + count - 1);
 }
 
 template<typename T>
 T& Deque<T>::Back() {
-    return (head.size() ? head.back() : tail[0]);
+    return Slot(first + count - 1);
 }
 
 template<typename T>
 void Deque<T>::PushBack(const T& elem) {
-    head.push_back(elem);
+    this->EmplaceBack(elem);
+}
+
+template<typename T>
+void Deque<T>::PushBack(T&& elem) {
+    this->EmplaceBack(std::move(elem));
 }
 
 template<typename T>
 void Deque<T>::PushFront(const T& elem) {
-    tail.push_back(elem);
+    this->EmplaceFront(elem);
+}
+
+template<typename T>
+void Deque<T>::PushFront(T&& elem) {
+    this->EmplaceFront(std::move(elem));
+}
+
+template<typename T>
+template<typename... Args>
+T& Deque<T>::EmplaceBack(Args&&... args) {
+    this->ReserveBack(1);
+    size_t pos = first + count;
+    T*& chunk = chunks[pos / kChunkSize];
+    bool fresh = chunk == nullptr;
+    if (fresh) {
+        chunk = this->AcquireChunk();
+    }
+    T* slot = chunk + pos % kChunkSize;
+    try {
+        ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+    } catch (...) {
+        if (fresh) {
+            this->ReleaseChunk(pos / kChunkSize);
+        }
+        throw;
+    }
+    ++count;
+    return *slot;
+}
+
+template<typename T>
+template<typename... Args>
+T& Deque<T>::EmplaceFront(Args&&... args) {
+    this->ReserveFront(1);
+    size_t pos = first - 1;
+    T*& chunk = chunks[pos / kChunkSize];
+    bool fresh = chunk == nullptr;
+    if (fresh) {
+        chunk = this->AcquireChunk();
+    }
+    T* slot = chunk + pos % kChunkSize;
+    try {
+        ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+    } catch (...) {
+        if (fresh) {
+            this->ReleaseChunk(pos / kChunkSize);
+        }
+        throw;
+    }
+    first = pos;
+    ++count;
+    return *slot;
+}
+
+template<typename T>
+template<typename Iter>
+void Deque<T>::Append(Iter from, Iter to) {
+    using category = typename std::iterator_traits<Iter>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        this->ReserveBack(static_cast<size_t>(std::distance(from, to)));
+    }
+    for (; from != to; ++from) {
+        this->EmplaceBack(*from);
+    }
+}
+
+template<typename T>
+template<typename BidirIt>
+void Deque<T>::Prepend(BidirIt from, BidirIt to) {
+    this->ReserveFront(static_cast<size_t>(std::distance(from, to)));
+    while (to != from) {
+        this->EmplaceFront(*--to);
+    }
 }
 
+template<typename T>
+void Deque<T>::PopFront() {
+    if (this->Empty()) {
+        throw std::out_of_range("Empty deque!");
+    }
+    std::destroy_at(&Slot(first));
+    if (first % kChunkSize == kChunkSize - 1 || count == 1) {
+        this->ReleaseChunk(first / kChunkSize);
+    }
+    ++first;
+    if (--count == 0) {
+        first = chunks.size() / 2 * kChunkSize;
+    }
+}
+
+template<typename T>
+void Deque<T>::PopBack() {
+    if (this->Empty()) {
+        throw std::out_of_range("Empty deque!");
+    }
+    size_t pos = first + count - 1;
+    std::destroy_at(&Slot(pos));
+    if (pos % kChunkSize == 0 || count == 1) {
+        this->ReleaseChunk(pos / kChunkSize);
+    }
+    if (--count == 0) {
+        first = chunks.size() / 2 * kChunkSize;
+    }
+}
+
+template<typename T>
+typename Deque<T>::iterator Deque<T>::begin() {
+    return iterator(chunks.empty() ? nullptr : chunks.data() + first / kChunkSize, first % kChunkSize);
+}
+
+template<typename T>
+typename Deque<T>::iterator Deque<T>::end() {
+    size_t pos = first + count;
+    return iterator(chunks.empty() ? nullptr : chunks.data() + pos / kChunkSize, pos % kChunkSize);
+}
+
+template<typename T>
+typename Deque<T>::const_iterator Deque<T>::begin() const {
+    return const_cast<Deque*>(this)->begin();
+}
+
+template<typename T>
+typename Deque<T>::const_iterator Deque<T>::end() const {
+    return const_cast<Deque*>(this)->end();
+}
+
+// Копия, которая бросает исключение на заданном по счёту копировании
+static int copies_until_throw = -1;
+static int live_throwing_copies = 0;
+
+struct ThrowingCopy {
+    ThrowingCopy() {
+        ++live_throwing_copies;
+    }
+    ThrowingCopy(const ThrowingCopy&) {
+        if (copies_until_throw-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        ++live_throwing_copies;
+    }
+    ~ThrowingCopy() {
+        --live_throwing_copies;
+    }
+};
+
 int main() {
     std::cout << "🧪 Начинаем тестирование Deque...\n";
 
@@ -154,7 +548,7 @@ int main() {
     std::cout << "✅ Неконстантный operator[] работает\n";
 
     // 4. At — проверка исключений
-    bool throws_on_bad_index = false;
+    [[maybe_unused]] bool throws_on_bad_index = false;
     try {
         d.At(100);
     } catch (const std::out_of_range&) {
@@ -201,12 +595,181 @@ int main() {
     std::cout << "✅ Большой тест: 1500 элементов, индексы корректны\n";
 
     // 8. Const-корректность (если компилируется — значит, всё ок)
-    const Deque<int>& cd = d;
+    [[maybe_unused]] const Deque<int>& cd = d;
     assert(cd[0] == -500);
     assert(cd.Front() == -500);
     assert(cd.Back() == 999);
     std::cout << "✅ Const-методы работают\n";
 
+    // 9. PopFront и PopBack
+    for (int i = 0; i < 500; ++i) {
+        d.PopFront();
+    }
+    assert(d.Front() == 0);
+    for (int i = 0; i < 500; ++i) {
+        d.PopBack();
+    }
+    assert(d.Size() == 500);
+    assert(d.Back() == 499);
+    while (!d.Empty()) {
+        d.PopBack();
+    }
+    [[maybe_unused]] bool throws_on_empty_pop = false;
+    try {
+        d.PopFront();
+    } catch (const std::out_of_range&) {
+        throws_on_empty_pop = true;
+    }
+    assert(throws_on_empty_pop);
+    std::cout << "✅ PopFront()/PopBack() работают, на пустом деке бросают std::out_of_range\n";
+
+    // 10. Адреса элементов не меняются при вставке в любой конец
+    d.PushBack(42);
+    [[maybe_unused]] const int* front_addr = &d.Front();
+    for (int i = 0; i < 100000; ++i) {
+        d.PushBack(i);
+        d.PushFront(-i);
+    }
+    assert(front_addr == &d[100000]);
+    assert(*front_addr == 42);
+    std::cout << "✅ Ссылки на элементы переживают PushFront/PushBack\n";
+
+    // 11. Очередь FIFO: элементы проходят через дек много раз
+    d.Clear();
+    for (int i = 0; i < 1000000; ++i) {
+        d.PushBack(i);
+        if (i % 3 != 0) {
+            assert(d.Front() == i - static_cast<int>(d.Size()) + 1);
+            d.PopFront();
+        }
+    }
+    assert(d.Size() == 333334);
+    assert(d.Back() == 999999);
+    std::cout << "✅ FIFO: 10^6 PushBack + PopFront\n";
+
+    // 12. Итераторы проходят дек чанк за чанком
+    d.Clear();
+    for (int i = 0; i < 5000; ++i) {
+        d.PushBack(i);
+        d.PushFront(-i - 1);
+    }
+    int expected = -5000;
+    for ([[maybe_unused]] int x : d) {
+        assert(x == expected);
+        ++expected;
+    }
+    assert(expected == 5000);
+    auto it = d.end();
+    for (int i = 4999; i >= 0; --i) {
+        --it;
+        assert(*it == i);
+    }
+    Deque<int> empty_deque;
+    assert(empty_deque.begin() == empty_deque.end());
+    std::cout << "✅ Итерация вперёд и назад через границы чанков\n";
+
+    // 13. Копирование, перемещение и нетривиальные типы
+    Deque<std::string> ds;
+    for (int i = 0; i < 3000; ++i) {
+        ds.PushBack(std::to_string(i));
+        ds.PushFront(std::to_string(-i));
+    }
+    Deque<std::string> ds_copy(ds);
+    assert(ds_copy.Size() == 6000);
+    assert(ds_copy.Front() == "-2999" && ds_copy.Back() == "2999");
+    Deque<std::string> ds_moved(std::move(ds));
+    assert(ds.Empty() && ds_moved.Size() == 6000);
+    ds = ds_copy;
+    ds.PopFront();
+    assert(ds.Size() == 5999 && ds_copy.Size() == 6000);
+    std::cout << "✅ Копирование и перемещение Deque<std::string>\n";
+
+    {
+        Deque<ThrowingCopy> source;
+        for (int i = 0; i < 5000; ++i) {
+            source.EmplaceBack();
+        }
+        copies_until_throw = 3000;
+        [[maybe_unused]] bool copy_failed = false;
+        try {
+            Deque<ThrowingCopy> failed_copy(source);
+        } catch (const std::runtime_error&) {
+            copy_failed = true;
+        }
+        assert(copy_failed && live_throwing_copies == 5000);
+        copies_until_throw = -1;
+    }
+    assert(live_throwing_copies == 0);
+    std::cout << "✅ Исключение при копировании не оставляет живых элементов\n";
+
+    // 14. Emplace, rvalue-перегрузки и вставка диапазонов
+    Deque<std::vector<int>> dv;
+    dv.EmplaceBack(3, 7);
+    dv.EmplaceFront(2, 1).push_back(5);
+    assert(dv.Front() == std::vector<int>({1, 1, 5}));
+    assert(dv.Back() == std::vector<int>({7, 7, 7}));
+    std::vector<int> payload(100, 42);
+    [[maybe_unused]] const int* payload_data = payload.data();
+    dv.PushBack(std::move(payload));
+    assert(dv.Back().data() == payload_data);
+    std::cout << "✅ EmplaceBack/EmplaceFront и PushBack(T&&) не копируют\n";
+
+    std::vector<std::string> words = {"a", "b", "c"};
+    Deque<std::string> dw;
+    dw.PushBack("x");
+    dw.Append(words.begin(), words.end());
+    dw.Prepend(words.begin(), words.end());
+    dw.Append(std::make_move_iterator(words.begin()), std::make_move_iterator(words.end()));
+    std::vector<std::string> expected_words = {"a", "b", "c", "x", "a", "b", "c", "a", "b", "c"};
+    assert(std::vector<std::string>(dw.begin(), dw.end()) == expected_words);
+    assert(words[0].empty());
+    std::istringstream tokens("p q r");
+    dw.Append(std::istream_iterator<std::string>(tokens), std::istream_iterator<std::string>());
+    assert(dw.Size() == 13 && dw.Back() == "r");
+    std::cout << "✅ Append/Prepend сохраняют порядок, move_iterator перемещает\n";
+
+    // 15. Бенчмарк: загрузка миллиона тяжёлых элементов копированием и перемещением
+    auto bench = [](const char* name, auto&& fill) {
+        auto start = std::chrono::steady_clock::now();
+        fill();
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        std::cout << "   " << name << ": " << std::fixed << dur.count() << " с\n";
+    };
+    const size_t kRecords = 1000000;
+    std::cout << "\n⏱  Загрузка " << kRecords << " записей:\n";
+    {
+        std::vector<std::string> src(kRecords, std::string(64, 's'));
+        Deque<std::string> by_copy, by_move, by_append;
+        bench("std::string PushBack(const T&)", [&] {
+            for (const auto& s : src) {
+                by_copy.PushBack(s);
+            }
+        });
+        auto src_copy = src;
+        bench("std::string PushBack(T&&)     ", [&] {
+            for (auto& s : src_copy) {
+                by_move.PushBack(std::move(s));
+            }
+        });
+        bench("std::string Append(move)      ", [&] {
+            by_append.Append(std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+        });
+        assert(by_copy.Size() == kRecords && by_move.Size() == kRecords && by_append.Size() == kRecords);
+    }
+    {
+        std::vector<std::vector<int>> src(kRecords, std::vector<int>(16, 1));
+        Deque<std::vector<int>> by_copy, by_append;
+        bench("vector<int> PushBack(const T&)", [&] {
+            for (const auto& v : src) {
+                by_copy.PushBack(v);
+            }
+        });
+        bench("vector<int> Append(move)      ", [&] {
+            by_append.Append(std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+        });
+        assert(by_copy.Size() == kRecords && by_append.Back().size() == 16);
+    }
+
     std::cout << "\n🎉 Все тесты пройдены успешно!\n";
     return 0;
 }
\ No newline at end of file
@@ -1,33 +1,3026 @@
 #include <unordered_map>
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <csignal>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <new>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-template <typename Key, typename Value>
+// Open-addressing hash map in the style of Abseil's Swiss table: one control
+// byte per slot (empty, deleted, or the low 7 bits of the hash), scanned 16 at
+// a time with SSE2, and key/value pairs stored inline in a flat array.
+// Erasing from a group that still has an empty slot leaves no tombstone,
+// because no probe sequence can have passed through such a group.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+private:
+    static constexpr size_t kGroupSize = 16;
+    static constexpr size_t npos = SIZE_MAX;
+    static constexpr int8_t kEmpty = -128;
+    static constexpr int8_t kDeleted = -2;
+
+    struct alignas(16) Group {
+        int8_t ctrl[kGroupSize];
+    };
+
+    struct alignas(value_type) Slot {
+        unsigned char bytes[sizeof(value_type)];
+    };
+
+    std::unique_ptr<Group[]> groups;
+    std::unique_ptr<Slot[]> slots;
+    size_t group_count = 0;  // zero or a power of two
+    size_t count = 0;
+    size_t tombstones = 0;
+    float max_load = 0.875f;
+    Hash hash_fn;
+    KeyEqual key_eq;
+
+    static uint32_t Match(const Group& g, int8_t h2) {
+#ifdef __SSE2__
+        __m128i ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(g.ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i != kGroupSize; ++i) {
+            mask |= static_cast<uint32_t>(g.ctrl[i] == h2) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static uint32_t MatchEmpty(const Group& g) {
+        return Match(g, kEmpty);
+    }
+
+    static uint32_t MatchEmptyOrDeleted(const Group& g) {
+#ifdef __SSE2__
+        __m128i ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(g.ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i != kGroupSize; ++i) {
+            mask |= static_cast<uint32_t>(g.ctrl[i] < -1) << i;
+        }
+        return mask;
+#endif
+    }
+
+    template <typename K>
+    size_t HashOf(const K& key) const {
+        // std::hash of integers is the identity, so spread the bits before
+        // taking the 7-bit tag and the group index from them.
+        uint64_t h = static_cast<uint64_t>(hash_fn(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    static int8_t H2(size_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    int8_t& Ctrl(size_t i) const {
+        return groups[i / kGroupSize].ctrl[i % kGroupSize];
+    }
+
+    value_type* SlotAt(size_t i) const {
+        return std::launder(reinterpret_cast<value_type*>(slots[i].bytes));
+    }
+
+    size_t Capacity() const {
+        return group_count * kGroupSize;
+    }
+
+    template <typename K>
+    size_t FindIndex(const K& key, size_t hash) const {
+        if (!group_count) {
+            return npos;
+        }
+        size_t mask = group_count - 1;
+        size_t g = (hash >> 7) & mask;
+        for (size_t step = 1; step <= group_count; ++step) {
+            for (uint32_t m = Match(groups[g], H2(hash)); m; m &= m - 1) {
+                size_t i = g * kGroupSize + __builtin_ctz(m);
+                if (key_eq(SlotAt(i)->first, key)) {
+                    return i;
+                }
+            }
+            if (MatchEmpty(groups[g])) {
+                return npos;
+            }
+            g = (g + step) & mask;
+        }
+        return npos;
+    }
+
+    size_t FindFirstNonFull(size_t hash) const {
+        size_t mask = group_count - 1;
+        size_t g = (hash >> 7) & mask;
+        for (size_t step = 1;; ++step) {
+            if (uint32_t m = MatchEmptyOrDeleted(groups[g])) {
+                return g * kGroupSize + __builtin_ctz(m);
+            }
+            g = (g + step) & mask;
+        }
+    }
+
+    void Rehash(size_t new_group_count) {
+        auto old_groups = std::move(groups);
+        auto old_slots = std::move(slots);
+        size_t old_capacity = Capacity();
+        groups.reset(new Group[new_group_count]);
+        slots.reset(new Slot[new_group_count * kGroupSize]);
+        group_count = new_group_count;
+        tombstones = 0;
+        for (size_t g = 0; g != new_group_count; ++g) {
+            std::fill_n(groups[g].ctrl, kGroupSize, kEmpty);
+        }
+        for (size_t i = 0; i != old_capacity; ++i) {
+            if (old_groups[i / kGroupSize].ctrl[i % kGroupSize] < 0) {
+                continue;
+            }
+            auto* old = std::launder(reinterpret_cast<value_type*>(old_slots[i].bytes));
+            size_t hash = HashOf(old->first);
+            size_t j = FindFirstNonFull(hash);
+            Ctrl(j) = H2(hash);
+            // The old pair is destroyed right after, so its key may be moved from.
+            ::new (static_cast<void*>(slots[j].bytes)) value_type(
+                std::move(const_cast<Key&>(old->first)), std::move(old->second));
+            old->~value_type();
+        }
+    }
+
+    bool NeedsRehash(size_t needed) const {
+        return needed + tombstones > static_cast<size_t>(Capacity() * max_load);
+    }
+
+    // Makes sure `needed` elements fit before a new slot is claimed.
+    void Reserve(size_t needed) {
+        if (!NeedsRehash(needed)) {
+            return;
+        }
+        size_t target = 1;
+        while (static_cast<size_t>(target * kGroupSize * max_load) < needed) {
+            target <<= 1;
+        }
+        // Plenty of tombstones and no real growth: rehash in place to drop them.
+        Rehash(std::max(target, needed * 2 <= Capacity() * max_load ? group_count : group_count * 2));
+    }
+
+    template <typename K, typename... Args>
+    std::pair<size_t, bool> TryEmplace(K&& key, Args&&... args) {
+        size_t hash = HashOf(key);
+        return TryEmplaceHashed(hash, std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    template <typename K, typename... Args>
+    std::pair<size_t, bool> TryEmplaceHashed(size_t hash, K&& key, Args&&... args) {
+        size_t i = FindIndex(key, hash);
+        if (i != npos) {
+            return {i, false};
+        }
+        if (NeedsRehash(count + 1)) {
+            // key and args may refer to a pair in this map, which Rehash
+            // moves, so the new pair is built first.
+            std::pair<Key, Value> pending(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+            Reserve(count + 1);
+            return {Place(hash, std::move(pending.first), std::move(pending.second)), true};
+        }
+        return {Place(hash, std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...)), true};
+    }
+
+    // Builds value_type(args...) in a free slot; capacity must already suffice.
+    template <typename... Args>
+    size_t Place(size_t hash, Args&&... args) {
+        size_t i = FindFirstNonFull(hash);
+        ::new (static_cast<void*>(slots[i].bytes)) value_type(std::forward<Args>(args)...);
+        if (Ctrl(i) == kDeleted) {
+            --tombstones;
+        }
+        Ctrl(i) = H2(hash);
+        ++count;
+        return i;
+    }
+
+    void EraseAt(size_t i) {
+        SlotAt(i)->~value_type();
+        if (MatchEmpty(groups[i / kGroupSize])) {
+            Ctrl(i) = kEmpty;
+        } else {
+            Ctrl(i) = kDeleted;
+            ++tombstones;
+        }
+        --count;
+    }
+
+public:
+    template <bool IsConst>
+    class Iterator {
+    private:
+        friend class FlatHashMap;
+        friend class Iterator<!IsConst>;
+        using Owner = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+
+        Owner* map = nullptr;
+        size_t i = 0;
+
+        Iterator(Owner* map, size_t i): map(map), i(i) {
+            SkipFree();
+        }
+
+        void SkipFree() {
+            while (i != map->Capacity() && map->Ctrl(i) < 0) {
+                ++i;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+
+        operator Iterator<true>() const {
+            return Iterator<true>(map, i);
+        }
+
+        reference operator * () const {
+            return *map->SlotAt(i);
+        }
+
+        pointer operator -> () const {
+            return map->SlotAt(i);
+        }
+
+        Iterator& operator ++ () {
+            ++i;
+            SkipFree();
+            return *this;
+        }
+
+        Iterator operator ++ (int) {
+            auto tmp(*this);
+            ++*this;
+            return tmp;
+        }
+
+        bool operator == (const Iterator& other) const {
+            return i == other.i;
+        }
+
+        bool operator != (const Iterator& other) const {
+            return i != other.i;
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatHashMap(float max_load_factor = 0.875f):
+        max_load(max_load_factor) {}
+
+    FlatHashMap(Hash hash, KeyEqual equal, float max_load_factor = 0.875f):
+        max_load(max_load_factor),
+        hash_fn(std::move(hash)),
+        key_eq(std::move(equal)) {}
+
+    FlatHashMap(const FlatHashMap& other):
+        max_load(other.max_load),
+        hash_fn(other.hash_fn),
+        key_eq(other.key_eq) {
+        // A local copy destroys what it built if an element copy throws.
+        FlatHashMap copy(other.hash_fn, other.key_eq, other.max_load);
+        copy.Reserve(other.count);
+        for (const auto& [key, value] : other) {
+            copy.TryEmplace(key, value);
+        }
+        swap(copy);
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept {
+        swap(other);
+    }
+
+    FlatHashMap& operator = (FlatHashMap other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~FlatHashMap() {
+        clear();
+    }
+
+    void swap(FlatHashMap& other) noexcept {
+        std::swap(groups, other.groups);
+        std::swap(slots, other.slots);
+        std::swap(group_count, other.group_count);
+        std::swap(count, other.count);
+        std::swap(tombstones, other.tombstones);
+        std::swap(max_load, other.max_load);
+        std::swap(hash_fn, other.hash_fn);
+        std::swap(key_eq, other.key_eq);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return !count;
+    }
+
+    size_t bucket_count() const {
+        return Capacity();
+    }
+
+    float load_factor() const {
+        return group_count ? static_cast<float>(count) / Capacity() : 0.0f;
+    }
+
+    float max_load_factor() const {
+        return max_load;
+    }
+
+    // Takes effect at the next growth; must be in (0, 1).
+    void max_load_factor(float value) {
+        max_load = value;
+    }
+
+    void reserve(size_t n) {
+        Reserve(n);
+    }
+
+    void clear() {
+        for (size_t i = 0; i != Capacity(); ++i) {
+            if (Ctrl(i) >= 0) {
+                SlotAt(i)->~value_type();
+            }
+            Ctrl(i) = kEmpty;
+        }
+        count = 0;
+        tombstones = 0;
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, Capacity());
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, Capacity());
+    }
+
+    iterator find(const Key& key) {
+        size_t i = FindIndex(key, HashOf(key));
+        return i == npos ? end() : iterator(this, i);
+    }
+
+    const_iterator find(const Key& key) const {
+        size_t i = FindIndex(key, HashOf(key));
+        return i == npos ? end() : const_iterator(this, i);
+    }
+
+    // Heterogeneous lookup, enabled when both Hash and KeyEqual are transparent.
+    template <typename K, typename H = Hash, typename E = KeyEqual,
+        typename = typename H::is_transparent, typename = typename E::is_transparent>
+    iterator find(const K& key) {
+        size_t i = FindIndex(key, HashOf(key));
+        return i == npos ? end() : iterator(this, i);
+    }
+
+    template <typename K, typename H = Hash, typename E = KeyEqual,
+        typename = typename H::is_transparent, typename = typename E::is_transparent>
+    const_iterator find(const K& key) const {
+        size_t i = FindIndex(key, HashOf(key));
+        return i == npos ? end() : const_iterator(this, i);
+    }
+
+    Value& operator [] (const Key& key) {
+        return SlotAt(TryEmplace(key).first)->second;
+    }
+
+    Value& operator [] (Key&& key) {
+        return SlotAt(TryEmplace(std::move(key)).first)->second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        auto [i, inserted] = TryEmplace(key, std::forward<Args>(args)...);
+        return {iterator(this, i), inserted};
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value) {
+        auto [i, inserted] = TryEmplace(key, std::forward<V>(value));
+        if (!inserted) {
+            SlotAt(i)->second = std::forward<V>(value);
+        }
+        return {iterator(this, i), inserted};
+    }
+
+    // Split lookup for batched probing: hash a batch of keys, prefetch where
+    // each one will land, then resolve them with the precomputed hashes.
+    template <typename K>
+    size_t hash(const K& key) const {
+        return HashOf(key);
+    }
+
+    void prefetch(size_t hash) const {
+        if (group_count) {
+            size_t g = (hash >> 7) & (group_count - 1);
+            __builtin_prefetch(&groups[g]);
+            __builtin_prefetch(SlotAt(g * kGroupSize));
+        }
+    }
+
+    template <typename K>
+    const_iterator find_hashed(const K& key, size_t hash) const {
+        size_t i = FindIndex(key, hash);
+        return i == npos ? end() : const_iterator(this, i);
+    }
+
+    template <typename V>
+    void insert_or_assign_hashed(const Key& key, V&& value, size_t hash) {
+        auto [i, inserted] = TryEmplaceHashed(hash, key, std::forward<V>(value));
+        if (!inserted) {
+            SlotAt(i)->second = std::forward<V>(value);
+        }
+    }
+
+    size_t erase(const Key& key) {
+        size_t i = FindIndex(key, HashOf(key));
+        if (i == npos) {
+            return 0;
+        }
+        EraseAt(i);
+        return 1;
+    }
+};
+
+// Hashes std::string, std::string_view and C strings alike, so a
+// FlatStringMap can be probed without building a std::string.
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>()(s);
+    }
+};
+
+template <typename Value>
+using FlatStringMap = FlatHashMap<std::string, Value, StringHash, std::equal_to<>>;
+
+// Hash maps whose find() takes any key their hash and equality accept. For
+// std::unordered_map that overload is C++20, so under C++17 it would build
+// a temporary Key anyway; only FlatHashMap qualifies there.
+template <typename Map, typename = void>
+struct HasTransparentLookup : std::false_type {};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+struct HasTransparentLookup<FlatHashMap<Key, Value, Hash, KeyEqual>,
+                            std::void_t<typename Hash::is_transparent, typename KeyEqual::is_transparent>>
+    : std::true_type {};
+
+#ifdef __cpp_lib_generic_unordered_lookup
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Alloc>
+struct HasTransparentLookup<std::unordered_map<Key, Value, Hash, KeyEqual, Alloc>,
+                            std::void_t<typename Hash::is_transparent, typename KeyEqual::is_transparent>>
+    : std::true_type {};
+#endif
+
+template <typename Map, typename = void>
+struct HasBatchedProbing : std::false_type {};
+
+template <typename Map>
+struct HasBatchedProbing<Map, std::void_t<decltype(std::declval<const Map&>().prefetch(size_t{}))>>
+    : std::true_type {};
+
+template <typename Map, typename = void>
+struct HasReserve : std::false_type {};
+
+template <typename Map>
+struct HasReserve<Map, std::void_t<decltype(std::declval<Map&>().reserve(size_t{}))>>
+    : std::true_type {};
+
+// insert_or_assign builds the value before the map can move its own pairs,
+// so `value` may refer to one of them.
+template <typename Map, typename = void>
+struct HasInsertOrAssign : std::false_type {};
+
+template <typename Map>
+struct HasInsertOrAssign<Map, std::void_t<decltype(std::declval<Map&>().insert_or_assign(
+    std::declval<const typename Map::key_type&>(), std::declval<const typename Map::mapped_type&>()))>>
+    : std::true_type {};
+
+template <typename Map, typename = void>
+struct HasTransparentCompare : std::false_type {};
+
+template <typename Map>
+struct HasTransparentCompare<Map, std::void_t<typename Map::key_compare::is_transparent>>
+    : std::true_type {};
+
+// Ordered map from byte strings to Value, built as an adaptive radix tree
+// (Leis et al., "The Adaptive Radix Tree"). Each inner node branches on one
+// key byte and is resized among 4, 16, 48 and 256 children as it fills and
+// drains, so sparse levels stay small. Single-child chains collapse into a
+// prefix stored in the node. Only the first kMaxPrefix bytes of a prefix are
+// kept; lookups skip the rest and compare the full key at the leaf. A leaf
+// is one allocation with the key bytes right after the entry. A key that is
+// a proper prefix of other keys is the node's `terminal` leaf. Keys compare
+// bytewise as unsigned char, which is also std::string's order.
+template <typename Value>
+class RadixTreeMap {
+public:
+    using key_type = std::string;
+    using mapped_type = Value;
+    using value_type = std::pair<const std::string_view, Value>;
+    using key_compare = std::less<>;
+
+private:
+    static constexpr uint32_t kMaxPrefix = 8;
+
+    struct Leaf {
+        value_type entry;  // entry.first views the key bytes stored after the struct
+
+        std::string_view Key() const {
+            return entry.first;
+        }
+    };
+
+    enum NodeType : uint8_t { kNode4, kNode16, kNode48, kNode256 };
+
+    struct Node {
+        NodeType type;
+        uint16_t count = 0;
+        uint32_t prefix_len = 0;
+        uint8_t prefix[kMaxPrefix];
+        Leaf* terminal = nullptr;  // the key ending right after the prefix
+
+        explicit Node(NodeType type): type(type) {}
+    };
+
+    // Children are tagged pointers: a Node*, or a Leaf* with the low bit set.
+    struct Node4 : Node {
+        uint8_t keys[4];  // sorted
+        void* children[4];
+
+        Node4(): Node(kNode4) {}
+    };
+
+    struct Node16 : Node {
+        uint8_t keys[16];  // sorted
+        void* children[16];
+
+        Node16(): Node(kNode16) {}
+    };
+
+    struct Node48 : Node {
+        uint8_t index[256] = {};  // slot + 1, or 0 when there is no child
+        void* children[48];  // slots [0, count) are in use
+
+        Node48(): Node(kNode48) {}
+    };
+
+    struct Node256 : Node {
+        void* children[256] = {};
+
+        Node256(): Node(kNode256) {}
+    };
+
+    // Path from the root to an iterator's leaf. `pos` is the last child that
+    // was visited: an index for Node4/16, a key byte for Node48/256, or -1.
+    struct Frame {
+        const Node* node;
+        int pos;
+    };
+
+    void* root = nullptr;
+    size_t count = 0;
+
+    static bool IsLeaf(const void* p) {
+        return reinterpret_cast<uintptr_t>(p) & 1;
+    }
+
+    static Leaf* AsLeaf(const void* p) {
+        return reinterpret_cast<Leaf*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t{1});
+    }
+
+    static void* Tag(Leaf* leaf) {
+        return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(leaf) | 1);
+    }
+
+    template <typename... Args>
+    static Leaf* NewLeaf(std::string_view key, Args&&... args) {
+        char* mem = static_cast<char*>(::operator new(sizeof(Leaf) + key.size()));
+        char* bytes = mem + sizeof(Leaf);
+        if (!key.empty()) {
+            std::memcpy(bytes, key.data(), key.size());
+        }
+        return ::new (static_cast<void*>(mem)) Leaf{value_type(std::piecewise_construct,
+            std::forward_as_tuple(bytes, key.size()), std::forward_as_tuple(std::forward<Args>(args)...))};
+    }
+
+    static void FreeLeaf(Leaf* leaf) {
+        leaf->~Leaf();
+        ::operator delete(static_cast<void*>(leaf));
+    }
+
+    static void FreeNode(Node* n) {
+        switch (n->type) {
+            case kNode4: delete static_cast<Node4*>(n); break;
+            case kNode16: delete static_cast<Node16*>(n); break;
+            case kNode48: delete static_cast<Node48*>(n); break;
+            case kNode256: delete static_cast<Node256*>(n); break;
+        }
+    }
+
+    static void FreeTree(void* p) {
+        if (p == nullptr) {
+            return;
+        }
+        if (IsLeaf(p)) {
+            FreeLeaf(AsLeaf(p));
+            return;
+        }
+        Node* n = static_cast<Node*>(p);
+        if (n->terminal) {
+            FreeLeaf(n->terminal);
+        }
+        int pos = -1;
+        const void* child;
+        while (NextChild(n, pos, child)) {
+            FreeTree(const_cast<void*>(child));
+        }
+        FreeNode(n);
+    }
+
+    static void* const* ChildSlot(const Node* n, uint8_t byte) {
+        switch (n->type) {
+            case kNode4: {
+                auto* n4 = static_cast<const Node4*>(n);
+                for (int i = 0; i < n->count; ++i) {
+                    if (n4->keys[i] == byte) {
+                        return &n4->children[i];
+                    }
+                }
+                return nullptr;
+            }
+            case kNode16: {
+                auto* n16 = static_cast<const Node16*>(n);
+#ifdef __SSE2__
+                __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n16->keys));
+                uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), keys))) & ((1u << n->count) - 1);
+                return mask ? &n16->children[__builtin_ctz(mask)] : nullptr;
+#else
+                for (int i = 0; i < n->count; ++i) {
+                    if (n16->keys[i] == byte) {
+                        return &n16->children[i];
+                    }
+                }
+                return nullptr;
+#endif
+            }
+            case kNode48: {
+                auto* n48 = static_cast<const Node48*>(n);
+                return n48->index[byte] ? &n48->children[n48->index[byte] - 1] : nullptr;
+            }
+            default: {
+                auto* n256 = static_cast<const Node256*>(n);
+                return n256->children[byte] ? &n256->children[byte] : nullptr;
+            }
+        }
+    }
+
+    // Finds the child for `byte`. On a miss, `pos` is set so that NextChild
+    // continues with the first child above `byte`.
+    static bool ChildAt(const Node* n, uint8_t byte, int& pos, const void*& child) {
+        if (n->type == kNode4 || n->type == kNode16) {
+            const uint8_t* keys = n->type == kNode4 ? static_cast<const Node4*>(n)->keys : static_cast<const Node16*>(n)->keys;
+            int i = 0;
+            while (i < n->count && keys[i] < byte) {
+                ++i;
+            }
+            if (i < n->count && keys[i] == byte) {
+                pos = i;
+                child = n->type == kNode4 ? static_cast<const Node4*>(n)->children[i] : static_cast<const Node16*>(n)->children[i];
+                return true;
+            }
+            pos = i - 1;
+            return false;
+        }
+        pos = byte;
+        void* const* slot = ChildSlot(n, byte);
+        if (slot) {
+            child = *slot;
+        }
+        return slot != nullptr;
+    }
+
+    // Moves `pos` to the next child in key order.
+    static bool NextChild(const Node* n, int& pos, const void*& child) {
+        switch (n->type) {
+            case kNode4:
+            case kNode16:
+                if (pos + 1 >= n->count) {
+                    return false;
+                }
+                ++pos;
+                child = n->type == kNode4 ? static_cast<const Node4*>(n)->children[pos] : static_cast<const Node16*>(n)->children[pos];
+                return true;
+            case kNode48: {
+                auto* n48 = static_cast<const Node48*>(n);
+                for (int b = pos + 1; b < 256; ++b) {
+                    if (n48->index[b]) {
+                        pos = b;
+                        child = n48->children[n48->index[b] - 1];
+                        return true;
+                    }
+                }
+                return false;
+            }
+            default: {
+                auto* n256 = static_cast<const Node256*>(n);
+                for (int b = pos + 1; b < 256; ++b) {
+                    if (n256->children[b]) {
+                        pos = b;
+                        child = n256->children[b];
+                        return true;
+                    }
+                }
+                return false;
+            }
+        }
+    }
+
+    // Any leaf below `p`; its key holds the node prefixes beyond kMaxPrefix.
+    static const Leaf* MinLeaf(const void* p) {
+        while (!IsLeaf(p)) {
+            const Node* n = static_cast<const Node*>(p);
+            if (n->terminal) {
+                return n->terminal;
+            }
+            int pos = -1;
+            NextChild(n, pos, p);
+        }
+        return AsLeaf(p);
+    }
+
+    static void SetPrefix(Node* n, std::string_view source, size_t from, size_t len) {
+        n->prefix_len = static_cast<uint32_t>(len);
+        std::memcpy(n->prefix, source.data() + from, std::min<size_t>(len, kMaxPrefix));
+    }
+
+    static uint8_t PrefixByte(const Node* n, size_t depth, uint32_t i) {
+        return i < kMaxPrefix ? n->prefix[i] : static_cast<uint8_t>(MinLeaf(n)->Key()[depth + i]);
+    }
+
+    // Number of leading prefix bytes of `n` that match `key` from `depth`.
+    static uint32_t MatchPrefix(const Node* n, std::string_view key, size_t depth) {
+        uint32_t stored = std::min(n->prefix_len, kMaxPrefix);
+        uint32_t i = 0;
+        for (; i < stored; ++i) {
+            if (depth + i >= key.size() || n->prefix[i] != static_cast<uint8_t>(key[depth + i])) {
+                return i;
+            }
+        }
+        if (i < n->prefix_len) {
+            std::string_view full = MinLeaf(n)->Key();
+            for (; i < n->prefix_len; ++i) {
+                if (depth + i >= key.size() || full[depth + i] != key[depth + i]) {
+                    return i;
+                }
+            }
+        }
+        return i;
+    }
+
+    template <typename N>
+    static void InsertSorted(N* n, uint8_t byte, void* child) {
+        int i = n->count;
+        while (i > 0 && n->keys[i - 1] > byte) {
+            n->keys[i] = n->keys[i - 1];
+            n->children[i] = n->children[i - 1];
+            --i;
+        }
+        n->keys[i] = byte;
+        n->children[i] = child;
+        ++n->count;
+    }
+
+    template <typename N>
+    static void RemoveSorted(N* n, uint8_t byte) {
+        int i = 0;
+        while (n->keys[i] != byte) {
+            ++i;
+        }
+        for (; i + 1 < n->count; ++i) {
+            n->keys[i] = n->keys[i + 1];
+            n->children[i] = n->children[i + 1];
+        }
+        --n->count;
+    }
+
+    static void CopyHeader(Node* to, const Node* from) {
+        to->count = from->count;
+        to->prefix_len = from->prefix_len;
+        std::memcpy(to->prefix, from->prefix, kMaxPrefix);
+        to->terminal = from->terminal;
+    }
+
+    // Adds a child to the node in *ref, moving it to the next size if full.
+    static void AddChild(void** ref, Node* n, uint8_t byte, void* child) {
+        switch (n->type) {
+            case kNode4: {
+                auto* n4 = static_cast<Node4*>(n);
+                if (n->count < 4) {
+                    InsertSorted(n4, byte, child);
+                    return;
+                }
+                auto* grown = new Node16();
+                CopyHeader(grown, n4);
+                std::copy_n(n4->keys, 4, grown->keys);
+                std::copy_n(n4->children, 4, grown->children);
+                delete n4;
+                *ref = grown;
+                InsertSorted(grown, byte, child);
+                return;
+            }
+            case kNode16: {
+                auto* n16 = static_cast<Node16*>(n);
+                if (n->count < 16) {
+                    InsertSorted(n16, byte, child);
+                    return;
+                }
+                auto* grown = new Node48();
+                CopyHeader(grown, n16);
+                for (int i = 0; i < 16; ++i) {
+                    grown->index[n16->keys[i]] = static_cast<uint8_t>(i + 1);
+                    grown->children[i] = n16->children[i];
+                }
+                delete n16;
+                *ref = n = grown;
+                break;
+            }
+            case kNode48:
+                if (n->count == 48) {
+                    auto* n48 = static_cast<Node48*>(n);
+                    auto* grown = new Node256();
+                    CopyHeader(grown, n48);
+                    for (int b = 0; b < 256; ++b) {
+                        if (n48->index[b]) {
+                            grown->children[b] = n48->children[n48->index[b] - 1];
+                        }
+                    }
+                    delete n48;
+                    *ref = n = grown;
+                }
+                break;
+            default:
+                break;
+        }
+        if (n->type == kNode48) {
+            auto* n48 = static_cast<Node48*>(n);
+            n48->children[n->count] = child;
+            n48->index[byte] = static_cast<uint8_t>(++n->count);
+        } else {
+            static_cast<Node256*>(n)->children[byte] = child;
+            ++n->count;
+        }
+    }
+
+    static void RemoveChild(Node* n, uint8_t byte) {
+        switch (n->type) {
+            case kNode4:
+                RemoveSorted(static_cast<Node4*>(n), byte);
+                break;
+            case kNode16:
+                RemoveSorted(static_cast<Node16*>(n), byte);
+                break;
+            case kNode48: {
+                // Keep slots dense: the last slot moves into the freed one.
+                auto* n48 = static_cast<Node48*>(n);
+                int slot = n48->index[byte] - 1;
+                n48->index[byte] = 0;
+                int last = --n->count;
+                if (slot != last) {
+                    n48->children[slot] = n48->children[last];
+                    for (int b = 0; b < 256; ++b) {
+                        if (n48->index[b] == last + 1) {
+                            n48->index[b] = static_cast<uint8_t>(slot + 1);
+                            break;
+                        }
+                    }
+                }
+                break;
+            }
+            default:
+                static_cast<Node256*>(n)->children[byte] = nullptr;
+                --n->count;
+        }
+    }
+
+    // Restores the node in *ref after a removal: collapses it into its only
+    // leaf or child, or moves it down a size once it is well under capacity.
+    static void Shrink(void** ref, size_t depth) {
+        Node* n = static_cast<Node*>(*ref);
+        if (n->count == 0) {
+            *ref = Tag(n->terminal);
+            FreeNode(n);
+            return;
+        }
+        if (n->count == 1 && !n->terminal) {
+            int pos = -1;
+            const void* only = nullptr;
+            NextChild(n, pos, only);
+            if (!IsLeaf(only)) {
+                Node* child = static_cast<Node*>(const_cast<void*>(only));
+                SetPrefix(child, MinLeaf(child)->Key(), depth, n->prefix_len + 1 + child->prefix_len);
+            }
+            *ref = const_cast<void*>(only);
+            FreeNode(n);
+            return;
+        }
+        if (n->type == kNode16 && n->count <= 3) {
+            auto* n16 = static_cast<Node16*>(n);
+            auto* shrunk = new Node4();
+            CopyHeader(shrunk, n16);
+            std::copy_n(n16->keys, n->count, shrunk->keys);
+            std::copy_n(n16->children, n->count, shrunk->children);
+            delete n16;
+            *ref = shrunk;
+        } else if (n->type == kNode48 && n->count <= 12) {
+            auto* n48 = static_cast<Node48*>(n);
+            auto* shrunk = new Node16();
+            CopyHeader(shrunk, n48);
+            int i = 0;
+            for (int b = 0; b < 256; ++b) {
+                if (n48->index[b]) {
+                    shrunk->keys[i] = static_cast<uint8_t>(b);
+                    shrunk->children[i++] = n48->children[n48->index[b] - 1];
+                }
+            }
+            delete n48;
+            *ref = shrunk;
+        } else if (n->type == kNode256 && n->count <= 36) {
+            auto* n256 = static_cast<Node256*>(n);
+            auto* shrunk = new Node48();
+            CopyHeader(shrunk, n256);
+            int i = 0;
+            for (int b = 0; b < 256; ++b) {
+                if (n256->children[b]) {
+                    shrunk->children[i] = n256->children[b];
+                    shrunk->index[b] = static_cast<uint8_t>(++i);
+                }
+            }
+            delete n256;
+            *ref = shrunk;
+        }
+    }
+
+    // Hangs a leaf off a fresh node whose prefix ends at `depth`.
+    static void Attach(Node4* n, Leaf* leaf, size_t depth) {
+        if (leaf->Key().size() == depth) {
+            n->terminal = leaf;
+        } else {
+            InsertSorted(n, static_cast<uint8_t>(leaf->Key()[depth]), Tag(leaf));
+        }
+    }
+
+    template <typename... Args>
+    std::pair<Leaf*, bool> Emplace(std::string_view key, Args&&... args) {
+        void** ref = &root;
+        size_t depth = 0;
+        while (true) {
+            void* p = *ref;
+            if (p == nullptr) {
+                Leaf* leaf = NewLeaf(key, std::forward<Args>(args)...);
+                *ref = Tag(leaf);
+                ++count;
+                return {leaf, true};
+            }
+            if (IsLeaf(p)) {
+                Leaf* old = AsLeaf(p);
+                std::string_view old_key = old->Key();
+                if (old_key == key) {
+                    return {old, false};
+                }
+                size_t common = depth;
+                while (common < old_key.size() && common < key.size() && old_key[common] == key[common]) {
+                    ++common;
+                }
+                auto* n = new Node4();
+                SetPrefix(n, key, depth, common - depth);
+                Leaf* leaf = NewLeaf(key, std::forward<Args>(args)...);
+                Attach(n, old, common);
+                Attach(n, leaf, common);
+                *ref = n;
+                ++count;
+                return {leaf, true};
+            }
+            Node* n = static_cast<Node*>(p);
+            uint32_t matched = MatchPrefix(n, key, depth);
+            if (matched < n->prefix_len) {
+                // The key leaves the prefix early: split it at `matched`.
+                auto* parent = new Node4();
+                SetPrefix(parent, key, depth, matched);
+                std::string_view full = MinLeaf(n)->Key();
+                uint8_t edge = static_cast<uint8_t>(full[depth + matched]);
+                SetPrefix(n, full, depth + matched + 1, n->prefix_len - matched - 1);
+                InsertSorted(parent, edge, n);
+                Leaf* leaf = NewLeaf(key, std::forward<Args>(args)...);
+                Attach(parent, leaf, depth + matched);
+                *ref = parent;
+                ++count;
+                return {leaf, true};
+            }
+            depth += n->prefix_len;
+            if (depth == key.size()) {
+                if (n->terminal) {
+                    return {n->terminal, false};
+                }
+                n->terminal = NewLeaf(key, std::forward<Args>(args)...);
+                ++count;
+                return {n->terminal, true};
+            }
+            uint8_t byte = static_cast<uint8_t>(key[depth]);
+            if (void* const* slot = ChildSlot(n, byte)) {
+                ref = const_cast<void**>(slot);
+                ++depth;
+                continue;
+            }
+            Leaf* leaf = NewLeaf(key, std::forward<Args>(args)...);
+            AddChild(ref, n, byte, Tag(leaf));
+            ++count;
+            return {leaf, true};
+        }
+    }
+
+    Leaf* FindLeaf(std::string_view key) const {
+        const void* p = root;
+        size_t depth = 0;
+        while (p != nullptr && !IsLeaf(p)) {
+            const Node* n = static_cast<const Node*>(p);
+            if (depth + n->prefix_len > key.size() ||
+                std::memcmp(n->prefix, key.data() + depth, std::min(n->prefix_len, kMaxPrefix)) != 0) {
+                return nullptr;
+            }
+            depth += n->prefix_len;
+            if (depth == key.size()) {
+                return n->terminal && n->terminal->Key() == key ? n->terminal : nullptr;
+            }
+            void* const* slot = ChildSlot(n, static_cast<uint8_t>(key[depth++]));
+            p = slot ? *slot : nullptr;
+        }
+        return p != nullptr && AsLeaf(p)->Key() == key ? AsLeaf(p) : nullptr;
+    }
+
+    // Steps the path to the next leaf in key order.
+    static Leaf* Advance(std::vector<Frame>& path) {
+        while (!path.empty()) {
+            const void* child;
+            if (!NextChild(path.back().node, path.back().pos, child)) {
+                path.pop_back();
+                continue;
+            }
+            if (IsLeaf(child)) {
+                return AsLeaf(child);
+            }
+            const Node* n = static_cast<const Node*>(child);
+            path.push_back({n, -1});
+            if (n->terminal) {
+                return n->terminal;
+            }
+        }
+        return nullptr;
+    }
+
+    // Fills `path` for the first leaf whose key is not less than `key`.
+    Leaf* Seek(std::vector<Frame>& path, std::string_view key) const {
+        path.clear();
+        const void* p = root;
+        size_t depth = 0;
+        while (p != nullptr) {
+            if (IsLeaf(p)) {
+                Leaf* leaf = AsLeaf(p);
+                return leaf->Key() >= key ? leaf : Advance(path);
+            }
+            const Node* n = static_cast<const Node*>(p);
+            uint32_t matched = MatchPrefix(n, key, depth);
+            if (matched < n->prefix_len) {
+                // The whole subtree sorts either before or after the key.
+                if (depth + matched < key.size() &&
+                    static_cast<uint8_t>(key[depth + matched]) > PrefixByte(n, depth, matched)) {
+                    return Advance(path);
+                }
+                path.push_back({n, -1});
+                return n->terminal ? n->terminal : Advance(path);
+            }
+            depth += n->prefix_len;
+            path.push_back({n, -1});
+            if (depth == key.size()) {
+                return n->terminal ? n->terminal : Advance(path);
+            }
+            if (!ChildAt(n, static_cast<uint8_t>(key[depth]), path.back().pos, p)) {
+                return Advance(path);
+            }
+            ++depth;
+        }
+        return nullptr;
+    }
+
+public:
+    template <bool IsConst>
+    class Iterator {
+    private:
+        friend class RadixTreeMap;
+        friend class Iterator<!IsConst>;
+
+        const RadixTreeMap* tree = nullptr;
+        Leaf* leaf = nullptr;
+        std::vector<Frame> path;
+        bool positioned = false;  // iterators from find() build `path` on their first ++
+
+        Iterator(const RadixTreeMap* tree, Leaf* leaf, std::vector<Frame> path, bool positioned):
+            tree(tree),
+            leaf(leaf),
+            path(std::move(path)),
+            positioned(positioned) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RadixTreeMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+
+        operator Iterator<true>() const {
+            return Iterator<true>(tree, leaf, path, positioned);
+        }
+
+        reference operator * () const {
+            return leaf->entry;
+        }
+
+        pointer operator -> () const {
+            return &leaf->entry;
+        }
+
+        Iterator& operator ++ () {
+            if (!positioned) {
+                tree->Seek(path, leaf->Key());
+                positioned = true;
+            }
+            leaf = Advance(path);
+            return *this;
+        }
+
+        Iterator operator ++ (int) {
+            auto tmp(*this);
+            ++*this;
+            return tmp;
+        }
+
+        bool operator == (const Iterator& other) const {
+            return leaf == other.leaf;
+        }
+
+        bool operator != (const Iterator& other) const {
+            return leaf != other.leaf;
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    RadixTreeMap() = default;
+
+    RadixTreeMap(const RadixTreeMap& other) {
+        for (const auto& [key, value] : other) {
+            Emplace(key, value);
+        }
+    }
+
+    RadixTreeMap(RadixTreeMap&& other) noexcept {
+        swap(other);
+    }
+
+    RadixTreeMap& operator = (RadixTreeMap other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~RadixTreeMap() {
+        clear();
+    }
+
+    void swap(RadixTreeMap& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(count, other.count);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return !count;
+    }
+
+    void clear() {
+        FreeTree(root);
+        root = nullptr;
+        count = 0;
+    }
+
+    iterator begin() {
+        return lower_bound(std::string_view());
+    }
+
+    iterator end() {
+        return iterator();
+    }
+
+    const_iterator begin() const {
+        return lower_bound(std::string_view());
+    }
+
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    iterator find(std::string_view key) {
+        Leaf* leaf = FindLeaf(key);
+        return leaf ? iterator(this, leaf, {}, false) : end();
+    }
+
+    const_iterator find(std::string_view key) const {
+        Leaf* leaf = FindLeaf(key);
+        return leaf ? const_iterator(this, leaf, {}, false) : end();
+    }
+
+    iterator lower_bound(std::string_view key) {
+        std::vector<Frame> path;
+        Leaf* leaf = Seek(path, key);
+        return leaf ? iterator(this, leaf, std::move(path), true) : end();
+    }
+
+    const_iterator lower_bound(std::string_view key) const {
+        std::vector<Frame> path;
+        Leaf* leaf = Seek(path, key);
+        return leaf ? const_iterator(this, leaf, std::move(path), true) : end();
+    }
+
+    Value& operator [] (std::string_view key) {
+        return Emplace(key).first->entry.second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args) {
+        auto [leaf, inserted] = Emplace(key, std::forward<Args>(args)...);
+        return {iterator(this, leaf, {}, false), inserted};
+    }
+
+    size_t erase(std::string_view key) {
+        void** ref = &root;
+        size_t depth = 0;
+        while (*ref != nullptr) {
+            if (IsLeaf(*ref)) {
+                // Only the root slot holds a leaf here; deeper leaves are handled below.
+                if (AsLeaf(*ref)->Key() != key) {
+                    return 0;
+                }
+                FreeLeaf(AsLeaf(*ref));
+                *ref = nullptr;
+                --count;
+                return 1;
+            }
+            Node* n = static_cast<Node*>(*ref);
+            size_t start = depth;
+            if (depth + n->prefix_len > key.size() ||
+                std::memcmp(n->prefix, key.data() + depth, std::min(n->prefix_len, kMaxPrefix)) != 0) {
+                return 0;
+            }
+            depth += n->prefix_len;
+            if (depth == key.size()) {
+                if (!n->terminal || n->terminal->Key() != key) {
+                    return 0;
+                }
+                FreeLeaf(n->terminal);
+                n->terminal = nullptr;
+                --count;
+                Shrink(ref, start);
+                return 1;
+            }
+            uint8_t byte = static_cast<uint8_t>(key[depth]);
+            void* const* slot = ChildSlot(n, byte);
+            if (slot == nullptr) {
+                return 0;
+            }
+            if (IsLeaf(*slot)) {
+                if (AsLeaf(*slot)->Key() != key) {
+                    return 0;
+                }
+                FreeLeaf(AsLeaf(*slot));
+                RemoveChild(n, byte);
+                --count;
+                Shrink(ref, start);
+                return 1;
+            }
+            ref = const_cast<void**>(slot);
+            ++depth;
+        }
+        return 0;
+    }
+};
+
+template <typename It>
+struct IteratorRange {
+    It first;
+    It last;
+
+    It begin() const {
+        return first;
+    }
+
+    It end() const {
+        return last;
+    }
+};
+
+template <typename Key, typename Value, typename Map = std::unordered_map<Key, Value>>
 class KeyValueStorage {
 private:
-      std::unordered_map<Key, Value> data;
+      Map data;
+
+    static constexpr size_t kBatch = 16;  // probes kept in flight by FindMany/InsertMany
+
+    // Looks `key` up as is when the map allows it, otherwise converts it to Key.
+    template <typename K>
+    auto FindIt(const K& key) const {
+        if constexpr (std::is_same_v<K, Key> || HasTransparentLookup<Map>::value || HasTransparentCompare<Map>::value) {
+            return data.find(key);
+        } else {
+            return data.find(Key(key));
+        }
+    }
 
 public:
+    KeyValueStorage() = default;
+
+    explicit KeyValueStorage(Map map):
+        data(std::move(map)) {}
+
     void Insert(const Key& key, const Value& value) {
-        data[key] = value;
+        if constexpr (HasInsertOrAssign<Map>::value) {
+            data.insert_or_assign(key, value);
+        } else {
+            data[key] = value;
+        }
     }
 
     void Remove(const Key& key) {
         data.erase(key);
     }
 
-    bool Find(const Key& key, Value* const value = nullptr) const;
+    // Copies the value into *value when it is not null.
+    template <typename K>
+    bool Find(const K& key, Value* const value = nullptr) const;
+
+    // Zero-copy lookup: a pointer to the stored value, or nullptr. The pointer
+    // is invalidated by the next Insert or Remove on this storage.
+    template <typename K>
+    const Value* Lookup(const K& key) const;
+
+    // Looks up keys[0..count): out_found[i] tells whether keys[i] is present,
+    // and out_values[i] receives its value if so (out_values may be null).
+    // With a map that supports it, hashes and prefetches kBatch keys ahead so
+    // their cache misses overlap instead of being paid one after another.
+    void FindMany(const Key* keys, size_t count, Value* out_values, bool* out_found) const;
+
+    void InsertMany(const Key* keys, const Value* values, size_t count);
+
+    // Ordered queries, for maps with lower_bound such as std::map or
+    // RadixTreeMap. LowerBound gives the first entry whose key is not less
+    // than `key`, or Data().end().
+    template <typename K>
+    typename Map::const_iterator LowerBound(const K& key) const;
+
+    // Entries with lo <= key < hi, in key order.
+    template <typename K>
+    IteratorRange<typename Map::const_iterator> Range(const K& lo, const K& hi) const;
+
+    // Entries whose key starts with `prefix`, in key order.
+    IteratorRange<typename Map::const_iterator> PrefixScan(std::string_view prefix) const;
+
+    const Map& Data() const {
+        return data;
+    }
 };
 
-template <typename Key, typename Value>
-bool KeyValueStorage<Key, Value>::Find(const Key& key, Value* const value) const {
-    auto it = data.find(key);
+template <typename Key, typename Value, typename Map>
+template <typename K>
+bool KeyValueStorage<Key, Value, Map>::Find(const K& key, Value* const value) const {
+    auto it = FindIt(key);
     if (value != nullptr && it != data.end())
         *value = it->second;
     return it != data.end();
 };
 
+template <typename Key, typename Value, typename Map>
+template <typename K>
+const Value* KeyValueStorage<Key, Value, Map>::Lookup(const K& key) const {
+    auto it = FindIt(key);
+    return it == data.end() ? nullptr : &it->second;
+}
+
+template <typename Key, typename Value, typename Map>
+void KeyValueStorage<Key, Value, Map>::FindMany(const Key* keys, size_t count, Value* out_values, bool* out_found) const {
+    if constexpr (HasBatchedProbing<Map>::value) {
+        size_t hashes[kBatch];
+        for (size_t start = 0; start < count; start += kBatch) {
+            size_t n = std::min(kBatch, count - start);
+            for (size_t j = 0; j != n; ++j) {
+                hashes[j] = data.hash(keys[start + j]);
+                data.prefetch(hashes[j]);
+            }
+            for (size_t j = 0; j != n; ++j) {
+                auto it = data.find_hashed(keys[start + j], hashes[j]);
+                out_found[start + j] = it != data.end();
+                if (out_values != nullptr && it != data.end()) {
+                    out_values[start + j] = it->second;
+                }
+            }
+        }
+    } else {
+        for (size_t i = 0; i != count; ++i) {
+            out_found[i] = Find(keys[i], out_values == nullptr ? nullptr : out_values + i);
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Map>
+void KeyValueStorage<Key, Value, Map>::InsertMany(const Key* keys, const Value* values, size_t count) {
+    if constexpr (HasReserve<Map>::value) {
+        data.reserve(data.size() + count);
+    }
+    if constexpr (HasBatchedProbing<Map>::value) {
+        size_t hashes[kBatch];
+        for (size_t start = 0; start < count; start += kBatch) {
+            size_t n = std::min(kBatch, count - start);
+            for (size_t j = 0; j != n; ++j) {
+                hashes[j] = data.hash(keys[start + j]);
+                data.prefetch(hashes[j]);
+            }
+            for (size_t j = 0; j != n; ++j) {
+                data.insert_or_assign_hashed(keys[start + j], values[start + j], hashes[j]);
+            }
+        }
+    } else {
+        for (size_t i = 0; i != count; ++i) {
+            Insert(keys[i], values[i]);
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Map>
+template <typename K>
+typename Map::const_iterator KeyValueStorage<Key, Value, Map>::LowerBound(const K& key) const {
+    if constexpr (std::is_same_v<K, Key> || HasTransparentCompare<Map>::value) {
+        return data.lower_bound(key);
+    } else {
+        return data.lower_bound(Key(key));
+    }
+}
+
+template <typename Key, typename Value, typename Map>
+template <typename K>
+IteratorRange<typename Map::const_iterator> KeyValueStorage<Key, Value, Map>::Range(const K& lo, const K& hi) const {
+    auto first = LowerBound(lo);
+    auto last = LowerBound(hi);
+    if (first == data.end() || (last != data.end() && !(first->first < last->first))) {
+        return {first, first};  // empty, including hi <= lo
+    }
+    return {first, last};
+}
+
+template <typename Key, typename Value, typename Map>
+IteratorRange<typename Map::const_iterator> KeyValueStorage<Key, Value, Map>::PrefixScan(std::string_view prefix) const {
+    // The range ends at the smallest string above every key with this
+    // prefix: drop trailing 0xFF bytes and increment the last one.
+    std::string upper(prefix);
+    while (!upper.empty() && static_cast<unsigned char>(upper.back()) == 0xFF) {
+        upper.pop_back();
+    }
+    if (upper.empty()) {
+        return {LowerBound(prefix), data.end()};
+    }
+    upper.back() = static_cast<char>(static_cast<unsigned char>(upper.back()) + 1);
+    return Range(prefix, std::string_view(upper));
+}
+
+// Capacity-bounded KeyValueStorage for use as a cache. Entries live in a
+// preallocated array threaded onto an intrusive LRU list by index, and never
+// more than `capacity` of them: an insert into a full cache evicts the least
+// recently used entry first. An optional per-entry TTL is checked lazily when
+// the entry is found.
+// Each key is stored once, in its node; the hash index holds node numbers and
+// hashes and compares them through the nodes. A reused node assigns the new
+// key over the old one, so keys without heap storage never allocate after
+// construction, and heap-owning keys such as std::string only when the new
+// key outgrows the buffer of the one it replaces.
+template <typename Key, typename Value, typename Clock = std::chrono::steady_clock,
+          typename Hash = std::hash<Key>>
+class LruKeyValueStorage {
+public:
+    using Duration = typename Clock::duration;
+    using TimePoint = typename Clock::time_point;
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t expirations = 0;
+    };
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Node {
+        std::optional<Key> key;  // kept after removal for reuse by the next key
+        Value value{};
+        TimePoint expires = TimePoint::max();
+        uint32_t prev = kNone;
+        uint32_t next = kNone;
+    };
+
+    struct NodeRef {
+        uint32_t i;
+    };
+
+    struct NodeHash {
+        using is_transparent = void;
+        const Node* nodes = nullptr;
+
+        size_t operator()(NodeRef ref) const {
+            return Hash()(*nodes[ref.i].key);
+        }
+
+        size_t operator()(const Key& key) const {
+            return Hash()(key);
+        }
+    };
+
+    struct NodeEqual {
+        using is_transparent = void;
+        const Node* nodes = nullptr;
+
+        bool operator()(NodeRef a, NodeRef b) const {
+            return a.i == b.i;  // a key is in the index at most once
+        }
+
+        bool operator()(NodeRef ref, const Key& key) const {
+            return *nodes[ref.i].key == key;
+        }
+    };
+
+    std::vector<Node> nodes;  // never reallocated: the index points into it
+    FlatHashMap<NodeRef, std::tuple<>, NodeHash, NodeEqual> index;
+    uint32_t head = kNone;  // most recently used
+    uint32_t tail = kNone;  // least recently used
+    uint32_t free_list = kNone;  // threaded through Node::next
+    Stats stats;
+
+    void Unlink(uint32_t i) {
+        Node& node = nodes[i];
+        (node.prev == kNone ? head : nodes[node.prev].next) = node.next;
+        (node.next == kNone ? tail : nodes[node.next].prev) = node.prev;
+    }
+
+    void PushFront(uint32_t i) {
+        nodes[i].prev = kNone;
+        nodes[i].next = head;
+        (head == kNone ? tail : nodes[head].prev) = i;
+        head = i;
+    }
+
+    void Drop(uint32_t i) {
+        Unlink(i);
+        index.erase(NodeRef{i});
+        nodes[i].next = free_list;
+        free_list = i;
+    }
+
+    TimePoint Deadline(Duration ttl) const {
+        return ttl == Duration::zero() ? TimePoint::max() : Clock::now() + ttl;
+    }
+
+public:
+    explicit LruKeyValueStorage(size_t capacity):
+        nodes(capacity),
+        index(NodeHash{nodes.data()}, NodeEqual{nodes.data()}) {
+        if (capacity == 0 || capacity >= kNone) {
+            throw std::invalid_argument("cache capacity must be in [1, 2^32 - 1)");
+        }
+        index.reserve(capacity);
+        for (size_t i = capacity; i-- > 0;) {
+            nodes[i].next = free_list;
+            free_list = static_cast<uint32_t>(i);
+        }
+    }
+
+    // A zero ttl means the entry never expires.
+    void Insert(const Key& key, const Value& value, Duration ttl = Duration::zero()) {
+        auto it = index.find(key);
+        uint32_t i;
+        if (it != index.end()) {
+            i = it->first.i;
+            Unlink(i);
+        } else {
+            if (free_list == kNone) {
+                ++stats.evictions;
+                Drop(tail);
+            }
+            i = free_list;
+            free_list = nodes[i].next;
+            if (nodes[i].key) {
+                *nodes[i].key = key;
+            } else {
+                nodes[i].key.emplace(key);
+            }
+            index.try_emplace(NodeRef{i});
+        }
+        nodes[i].value = value;
+        nodes[i].expires = Deadline(ttl);
+        PushFront(i);
+    }
+
+    void Remove(const Key& key) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            Drop(it->first.i);
+        }
+    }
+
+    // A hit refreshes the entry's recency; an expired entry is removed and
+    // counted as a miss.
+    bool Find(const Key& key, Value* const value = nullptr) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++stats.misses;
+            return false;
+        }
+        uint32_t i = it->first.i;
+        if (nodes[i].expires != TimePoint::max() && nodes[i].expires <= Clock::now()) {
+            ++stats.expirations;
+            ++stats.misses;
+            Drop(i);
+            return false;
+        }
+        ++stats.hits;
+        Unlink(i);
+        PushFront(i);
+        if (value != nullptr) {
+            *value = nodes[i].value;
+        }
+        return true;
+    }
+
+    LruKeyValueStorage(const LruKeyValueStorage&) = delete;
+    LruKeyValueStorage& operator =(const LruKeyValueStorage&) = delete;
+    LruKeyValueStorage(LruKeyValueStorage&&) = default;  // the node buffer moves along
+    LruKeyValueStorage& operator =(LruKeyValueStorage&&) = default;
+
+    size_t Size() const {
+        return index.size();
+    }
+
+    size_t Capacity() const {
+        return nodes.size();
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+};
+
+// KeyValueStorage split into a power-of-two number of shards by key hash,
+// each behind its own reader-writer lock. Every operation touches exactly one
+// shard under its lock, so Insert, Remove and Find stay linearizable, while
+// concurrent Finds never block each other and writers to different shards
+// never contend.
+template <typename Key, typename Value, typename Map = std::unordered_map<Key, Value>, typename Hash = std::hash<Key>>
+class ConcurrentKeyValueStorage {
+private:
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        KeyValueStorage<Key, Value, Map> storage;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shard_mask;
+    Hash hasher;
+
+    Shard& ShardOf(const Key& key) const {
+        // Take the top bits, the backend map indexes its buckets by the low ones.
+        uint64_t h = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ULL;
+        return shards[(h >> 32) & shard_mask];
+    }
+
+public:
+    explicit ConcurrentKeyValueStorage(size_t shard_count = 64) {
+        size_t n = 1;
+        while (n < shard_count) {
+            n <<= 1;
+        }
+        shards.reset(new Shard[n]);
+        shard_mask = n - 1;
+    }
+
+    void Insert(const Key& key, const Value& value) {
+        Shard& shard = ShardOf(key);
+        std::unique_lock lock(shard.mutex);
+        shard.storage.Insert(key, value);
+    }
+
+    void Remove(const Key& key) {
+        Shard& shard = ShardOf(key);
+        std::unique_lock lock(shard.mutex);
+        shard.storage.Remove(key);
+    }
+
+    bool Find(const Key& key, Value* const value = nullptr) const {
+        const Shard& shard = ShardOf(key);
+        std::shared_lock lock(shard.mutex);
+        return shard.storage.Find(key, value);
+    }
+
+    // Sum over shards locked one at a time, not an atomic snapshot.
+    size_t Size() const {
+        size_t total = 0;
+        for (size_t i = 0; i <= shard_mask; ++i) {
+            std::shared_lock lock(shards[i].mutex);
+            total += shards[i].storage.Data().size();
+        }
+        return total;
+    }
+};
+
+// Byte encoding for DurableKeyValueStorage: raw bytes for trivially copyable
+// types, the characters themselves for std::string.
+template <typename T>
+struct Codec {
+    static_assert(std::is_trivially_copyable_v<T>, "provide a Codec specialization");
+
+    static void Append(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static T Read(const char* data, size_t size) {
+        T value;
+        std::memcpy(&value, data, std::min(size, sizeof(T)));
+        return value;
+    }
+};
+
+template <>
+struct Codec<std::string> {
+    static void Append(std::string& out, const std::string& value) {
+        out.append(value);
+    }
+
+    static std::string Read(const char* data, size_t size) {
+        return std::string(data, size);
+    }
+};
+
+// KeyValueStorage that survives restarts. Insert and Remove are appended to a
+// write-ahead log and made durable in groups: one write + fdatasync per
+// `group_commit` operations, or on Commit(). Compact() folds everything into
+// a snapshot laid out as an on-disk open-addressing table; on startup the
+// snapshot is only mmap-ed and probed lazily, and just the log tail is
+// replayed into an in-memory overlay, so opening costs O(log tail).
+// Operations since the last commit are lost on a crash; a torn last record
+// is detected by its checksum and cut off.
+template <typename Key, typename Value>
+class DurableKeyValueStorage {
+public:
+    struct Options {
+        size_t group_commit = 64;  // operations per fdatasync
+        size_t compact_log_bytes = 64 << 20;  // auto-compact once the log is this big
+    };
+
+private:
+    struct SnapshotHeader {
+        char magic[8];
+        uint64_t bucket_count;  // power of two
+        uint64_t entry_count;
+        uint64_t records_offset;
+    };
+
+    struct RecordHeader {
+        uint64_t hash;
+        uint32_t key_size;
+        uint32_t value_size;
+    };
+
+    struct LogHeader {
+        uint32_t checksum;  // of everything after this field
+        uint32_t op;
+        uint32_t key_size;
+        uint32_t value_size;
+    };
+
+    static constexpr char kMagic[8] = {'K', 'V', 'S', 'N', 'A', 'P', '1', '\0'};
+    static constexpr uint32_t kInsert = 1;
+    static constexpr uint32_t kRemove = 2;
+
+    std::string snapshot_path, log_path;
+    Options options;
+    int log_fd = -1;
+    size_t log_size = 0;
+    std::string pending;  // encoded log records not yet written
+    size_t pending_ops = 0;
+    bool log_torn = false;  // a failed Commit may have left part of pending past log_size
+    const char* snapshot = nullptr;
+    size_t snapshot_size = 0;
+    KeyValueStorage<Key, std::optional<Value>> overlay;  // nullopt marks a removal
+
+    [[noreturn]] static void Fail(const std::string& what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    // FNV-1a: the snapshot outlives the process, so the hash must be stable.
+    static uint64_t HashBytes(const char* data, size_t size) {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i != size; ++i) {
+            h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+    static size_t Align8(size_t n) {
+        return (n + 7) & ~size_t{7};
+    }
+
+    static void WriteAll(int fd, const char* data, size_t size, const std::string& path) {
+        while (size) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                Fail("write " + path);
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    static void SyncDirectory(const std::string& path) {
+        std::string dir = std::filesystem::path(path).parent_path().string();
+        int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    void MapSnapshot() {
+        int fd = ::open(snapshot_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                return;
+            }
+            Fail("open " + snapshot_path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            Fail("stat " + snapshot_path);
+        }
+        snapshot_size = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, snapshot_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            Fail("mmap " + snapshot_path);
+        }
+        snapshot = static_cast<const char*>(addr);
+        ::madvise(addr, snapshot_size, MADV_RANDOM);
+        if (snapshot_size < sizeof(SnapshotHeader) || std::memcmp(Header().magic, kMagic, sizeof(kMagic)) != 0
+            || Header().bucket_count == 0 || (Header().bucket_count & (Header().bucket_count - 1)) != 0
+            || Header().bucket_count > (snapshot_size - sizeof(SnapshotHeader)) / sizeof(uint64_t)
+            || Header().records_offset != sizeof(SnapshotHeader) + Header().bucket_count * sizeof(uint64_t)) {
+            UnmapSnapshot();
+            Corrupt();
+        }
+    }
+
+    [[noreturn]] void Corrupt() const {
+        throw std::runtime_error("corrupt snapshot " + snapshot_path);
+    }
+
+    void UnmapSnapshot() {
+        if (snapshot != nullptr) {
+            ::munmap(const_cast<char*>(snapshot), snapshot_size);
+            snapshot = nullptr;
+            snapshot_size = 0;
+        }
+    }
+
+    const SnapshotHeader& Header() const {
+        return *reinterpret_cast<const SnapshotHeader*>(snapshot);
+    }
+
+    const uint64_t* Buckets() const {
+        return reinterpret_cast<const uint64_t*>(snapshot + sizeof(SnapshotHeader));
+    }
+
+    // Offsets and sizes come from the file, so they are checked against the
+    // mapping before anything behind them is read.
+    const RecordHeader* Record(uint64_t offset) const {
+        if (offset < Header().records_offset || offset % alignof(RecordHeader) != 0
+            || offset > snapshot_size - sizeof(RecordHeader)) {
+            Corrupt();
+        }
+        const RecordHeader* rec = reinterpret_cast<const RecordHeader*>(snapshot + offset);
+        if (uint64_t{rec->key_size} + rec->value_size > snapshot_size - offset - sizeof(RecordHeader)) {
+            Corrupt();
+        }
+        return rec;
+    }
+
+    const RecordHeader* FindInSnapshot(const std::string& key) const {
+        if (snapshot == nullptr) {
+            return nullptr;
+        }
+        uint64_t hash = HashBytes(key.data(), key.size());
+        uint64_t mask = Header().bucket_count - 1;
+        for (uint64_t b = hash & mask, probes = 0;; b = (b + 1) & mask, ++probes) {
+            uint64_t offset = Buckets()[b];
+            if (offset == 0) {
+                return nullptr;
+            }
+            if (probes == mask) {
+                Corrupt();  // a valid table always has an empty bucket
+            }
+            const RecordHeader* rec = Record(offset);
+            if (rec->hash == hash && rec->key_size == key.size()
+                && std::memcmp(rec + 1, key.data(), key.size()) == 0) {
+                return rec;
+            }
+        }
+    }
+
+    void Log(uint32_t op, const Key& key, const Value* value) {
+        size_t start = pending.size();
+        pending.resize(start + sizeof(LogHeader));
+        Codec<Key>::Append(pending, key);
+        size_t key_size = pending.size() - start - sizeof(LogHeader);
+        if (value != nullptr) {
+            Codec<Value>::Append(pending, *value);
+        }
+        LogHeader header{0, op, static_cast<uint32_t>(key_size),
+            static_cast<uint32_t>(pending.size() - start - sizeof(LogHeader) - key_size)};
+        std::memcpy(pending.data() + start, &header, sizeof(header));
+        const char* body = pending.data() + start + sizeof(uint32_t);
+        header.checksum = static_cast<uint32_t>(HashBytes(body, pending.size() - start - sizeof(uint32_t)));
+        std::memcpy(pending.data() + start, &header.checksum, sizeof(uint32_t));
+        if (++pending_ops >= options.group_commit) {
+            Commit();
+        }
+    }
+
+    void ReplayLog() {
+        std::string log(log_size, '\0');
+        for (size_t done = 0; done < log_size;) {
+            ssize_t got = ::pread(log_fd, log.data() + done, log_size - done, static_cast<off_t>(done));
+            if (got <= 0) {
+                Fail("read " + log_path);
+            }
+            done += static_cast<size_t>(got);
+        }
+        size_t pos = 0;
+        while (pos + sizeof(LogHeader) <= log.size()) {
+            LogHeader header;
+            std::memcpy(&header, log.data() + pos, sizeof(header));
+            size_t end = pos + sizeof(LogHeader) + header.key_size + header.value_size;
+            if (end > log.size() || (header.op != kInsert && header.op != kRemove)
+                || header.checksum != static_cast<uint32_t>(HashBytes(log.data() + pos + sizeof(uint32_t), end - pos - sizeof(uint32_t)))) {
+                break;
+            }
+            const char* key = log.data() + pos + sizeof(LogHeader);
+            Key decoded = Codec<Key>::Read(key, header.key_size);
+            if (header.op == kInsert) {
+                overlay.Insert(decoded, Codec<Value>::Read(key + header.key_size, header.value_size));
+            } else {
+                overlay.Insert(decoded, std::nullopt);
+            }
+            pos = end;
+        }
+        if (pos != log_size) {
+            // Torn or corrupt tail from a crash mid-write: drop it.
+            if (::ftruncate(log_fd, static_cast<off_t>(pos)) != 0) {
+                Fail("truncate " + log_path);
+            }
+            log_size = pos;
+        }
+    }
+
+public:
+    explicit DurableKeyValueStorage(const std::string& directory, Options options = Options()):
+        snapshot_path(directory + "/snapshot"),
+        log_path(directory + "/wal"),
+        options(options) {
+        std::filesystem::create_directories(directory);
+        MapSnapshot();
+        log_fd = ::open(log_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (log_fd < 0) {
+            UnmapSnapshot();
+            Fail("open " + log_path);
+        }
+        log_size = static_cast<size_t>(::lseek(log_fd, 0, SEEK_END));
+        ReplayLog();
+    }
+
+    DurableKeyValueStorage(const DurableKeyValueStorage&) = delete;
+    DurableKeyValueStorage& operator =(const DurableKeyValueStorage&) = delete;
+
+    ~DurableKeyValueStorage() {
+        try {
+            Commit();
+        } catch (const std::exception&) {
+            // Nothing sensible to do from a destructor; uncommitted writes are lost.
+        }
+        ::close(log_fd);
+        UnmapSnapshot();
+    }
+
+    void Insert(const Key& key, const Value& value) {
+        overlay.Insert(key, value);
+        Log(kInsert, key, &value);
+    }
+
+    void Remove(const Key& key) {
+        overlay.Insert(key, std::nullopt);
+        Log(kRemove, key, nullptr);
+    }
+
+    bool Find(const Key& key, Value* const value = nullptr) const {
+        std::optional<Value> recent;
+        if (overlay.Find(key, &recent)) {
+            if (value != nullptr && recent) {
+                *value = *recent;
+            }
+            return recent.has_value();
+        }
+        std::string encoded;
+        Codec<Key>::Append(encoded, key);
+        const RecordHeader* rec = FindInSnapshot(encoded);
+        if (rec != nullptr && value != nullptr) {
+            *value = Codec<Value>::Read(reinterpret_cast<const char*>(rec + 1) + rec->key_size, rec->value_size);
+        }
+        return rec != nullptr;
+    }
+
+    // Writes and syncs the pending group of log records.
+    void Commit() {
+        if (pending.empty()) {
+            return;
+        }
+        if (log_torn) {
+            if (::ftruncate(log_fd, static_cast<off_t>(log_size)) != 0) {
+                Fail("truncate " + log_path);
+            }
+            log_torn = false;
+        }
+        try {
+            WriteAll(log_fd, pending.data(), pending.size(), log_path);
+            if (::fdatasync(log_fd) != 0) {
+                Fail("fdatasync " + log_path);
+            }
+        } catch (const std::system_error&) {
+            // Part of the group may be in the log already. Replay would stop at
+            // that torn prefix and drop everything appended after it, so cut
+            // it off before a retry appends the group again.
+            log_torn = ::ftruncate(log_fd, static_cast<off_t>(log_size)) != 0;
+            throw;
+        }
+        log_size += pending.size();
+        pending.clear();
+        pending_ops = 0;
+        if (log_size >= options.compact_log_bytes) {
+            Compact();
+        }
+    }
+
+    // Merges the snapshot with the overlay into a new snapshot, atomically
+    // replaces the old one and empties the log. Replaying a log over a newer
+    // snapshot is harmless, so a crash between the two steps loses nothing.
+    void Compact() {
+        struct Source {
+            uint64_t hash;
+            const char* key;
+            uint32_t key_size;
+            const char* value;
+            uint32_t value_size;
+        };
+        std::vector<Source> entries;
+        std::vector<std::string> encoded;  // overlay keys and values
+        encoded.reserve(2 * overlay.Data().size());
+        for (const auto& [key, value] : overlay.Data()) {
+            if (!value) {
+                continue;
+            }
+            encoded.emplace_back();
+            Codec<Key>::Append(encoded.back(), key);
+            encoded.emplace_back();
+            Codec<Value>::Append(encoded.back(), *value);
+            const std::string& k = encoded[encoded.size() - 2];
+            const std::string& v = encoded.back();
+            entries.push_back({HashBytes(k.data(), k.size()), k.data(), static_cast<uint32_t>(k.size()),
+                v.data(), static_cast<uint32_t>(v.size())});
+        }
+        if (snapshot != nullptr) {
+            ::madvise(const_cast<char*>(snapshot), snapshot_size, MADV_SEQUENTIAL);
+            for (size_t offset = Header().records_offset; offset < snapshot_size;) {
+                const RecordHeader* rec = Record(offset);
+                const char* key = reinterpret_cast<const char*>(rec + 1);
+                if (!overlay.Find(Codec<Key>::Read(key, rec->key_size))) {
+                    entries.push_back({rec->hash, key, rec->key_size, key + rec->key_size, rec->value_size});
+                }
+                offset += Align8(sizeof(RecordHeader) + rec->key_size + rec->value_size);
+            }
+        }
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.bucket_count = 16;
+        while (header.bucket_count < 2 * entries.size()) {
+            header.bucket_count <<= 1;
+        }
+        header.entry_count = entries.size();
+        header.records_offset = sizeof(SnapshotHeader) + header.bucket_count * sizeof(uint64_t);
+        std::vector<uint64_t> buckets(header.bucket_count, 0);
+        uint64_t offset = header.records_offset;
+        for (const auto& e : entries) {
+            uint64_t b = e.hash & (header.bucket_count - 1);
+            while (buckets[b] != 0) {
+                b = (b + 1) & (header.bucket_count - 1);
+            }
+            buckets[b] = offset;
+            offset += Align8(sizeof(RecordHeader) + e.key_size + e.value_size);
+        }
+
+        std::string tmp_path = snapshot_path + ".tmp";
+        int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            Fail("open " + tmp_path);
+        }
+        std::string buffer(reinterpret_cast<const char*>(&header), sizeof(header));
+        buffer.append(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(uint64_t));
+        for (const auto& e : entries) {
+            RecordHeader rec{e.hash, e.key_size, e.value_size};
+            buffer.append(reinterpret_cast<const char*>(&rec), sizeof(rec));
+            buffer.append(e.key, e.key_size);
+            buffer.append(e.value, e.value_size);
+            buffer.resize(Align8(buffer.size()), '\0');
+            if (buffer.size() >= (1 << 20)) {
+                WriteAll(fd, buffer.data(), buffer.size(), tmp_path);
+                buffer.clear();
+            }
+        }
+        WriteAll(fd, buffer.data(), buffer.size(), tmp_path);
+        if (::fsync(fd) != 0) {
+            ::close(fd);
+            Fail("fsync " + tmp_path);
+        }
+        ::close(fd);
+        if (::rename(tmp_path.c_str(), snapshot_path.c_str()) != 0) {
+            Fail("rename " + tmp_path);
+        }
+        SyncDirectory(snapshot_path);
+
+        UnmapSnapshot();
+        MapSnapshot();
+        pending.clear();
+        pending_ops = 0;
+        if (::ftruncate(log_fd, 0) != 0 || ::fsync(log_fd) != 0) {
+            Fail("truncate " + log_path);
+        }
+        log_size = 0;
+        log_torn = false;
+        overlay = KeyValueStorage<Key, std::optional<Value>>();
+    }
+
+    size_t LogSize() const {
+        return log_size;
+    }
+};
+
+// Live heap bytes, for the memory-per-entry numbers in main(). Each block
+// carries its size in a 16-byte header so operator delete can subtract it.
+std::atomic<size_t> heap_bytes{0};
+std::atomic<size_t> heap_allocations{0};
+
+void* operator new(size_t size) {
+    auto* block = static_cast<unsigned char*>(std::malloc(size + 16));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    heap_bytes.fetch_add(size, std::memory_order_relaxed);
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return block + 16;
+}
+
+// noinline: inlined into a container's deallocate, GCC 12 at -O3 reports
+// the header read at ptr - 16 as -Warray-bounds and the free() of a pointer
+// from operator new as -Wmismatched-new-delete, both false positives.
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        auto* block = static_cast<unsigned char*>(ptr) - 16;
+        heap_bytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+template <typename Storage, typename Key>
+void Benchmark(const char* name, const std::vector<Key>& keys, const std::vector<Key>& missing) {
+    using clock = std::chrono::steady_clock;
+    auto mops = [](clock::time_point start, size_t ops) {
+        std::chrono::duration<double> dur = clock::now() - start;
+        return ops / dur.count() / 1e6;
+    };
+    size_t before = heap_bytes;
+    {
+        Storage st;
+        auto start = clock::now();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            st.Insert(keys[i], static_cast<int>(i));
+        }
+        double insert = mops(start, keys.size());
+        double per_entry = static_cast<double>(heap_bytes - before) / keys.size();
+
+        start = clock::now();
+        size_t found = 0;
+        for (const auto& key : keys) {
+            found += st.Find(key);
+        }
+        double hit = mops(start, keys.size());
+        start = clock::now();
+        for (const auto& key : missing) {
+            found += st.Find(key);
+        }
+        double miss = mops(start, missing.size());
+        assert(found == keys.size());
+
+        start = clock::now();
+        for (const auto& key : keys) {
+            st.Remove(key);
+        }
+        double erase = mops(start, keys.size());
+        [[maybe_unused]] const bool erased_found = st.Find(keys[0]);
+        assert(!erased_found);
+        std::cout << "   " << name << std::fixed
+                  << "  вставка " << insert << ", поиск " << hit << " / промах " << miss
+                  << ", удаление " << erase << " млн/с, " << per_entry << " байт на запись, найдено " << found << "\n";
+    }
+}
+
+// Value whose copy throws on a chosen copy, counting live instances.
+static int copies_until_throw = -1;
+static int live_throwing_copies = 0;
+
+struct ThrowingCopy {
+    ThrowingCopy() {
+        ++live_throwing_copies;
+    }
+    ThrowingCopy(const ThrowingCopy&) {
+        if (copies_until_throw-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        ++live_throwing_copies;
+    }
+    ThrowingCopy& operator=(const ThrowingCopy&) = default;
+    ~ThrowingCopy() {
+        --live_throwing_copies;
+    }
+};
+
+// Manually advanced clock for the TTL tests.
+struct FakeClock {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<FakeClock>;
+    static constexpr bool is_steady = true;
+    static inline time_point current{};
+
+    static time_point now() {
+        return current;
+    }
+};
+
 int main() {
+    std::cout << "🧪 Тестирование KeyValueStorage...\n";
+
     KeyValueStorage<int, int> st;
     st.Insert(4, 44);
     st.Find(4);
-}
\ No newline at end of file
+
+    // 1. Стандартный и плоский бэкенды ведут себя одинаково
+    KeyValueStorage<std::string, int, FlatHashMap<std::string, int>> flat;
+    [[maybe_unused]] int value = 0;
+    assert(!flat.Find("a"));
+    flat.Insert("a", 1);
+    flat.Insert("b", 2);
+    flat.Insert("a", 3);
+    assert(flat.Find("a", &value) && value == 3);
+    assert(flat.Find("b", &value) && value == 2);
+    flat.Remove("a");
+    flat.Remove("missing");
+    assert(!flat.Find("a") && flat.Data().size() == 1);
+    std::cout << "✅ FlatHashMap: Insert/Find/Remove\n";
+
+    // 2. Случайные операции сверяются с std::unordered_map
+    std::mt19937 rng(1);
+    FlatHashMap<int, int> checked;
+    std::unordered_map<int, int> reference;
+    for (int step = 0; step < 300000; ++step) {
+        int key = static_cast<int>(rng() % 5000);
+        switch (rng() % 3) {
+            case 0:
+                checked[key] = step;
+                reference[key] = step;
+                break;
+            case 1: {
+                [[maybe_unused]] const size_t erased = checked.erase(key);
+                [[maybe_unused]] const size_t reference_erased = reference.erase(key);
+                assert(erased == reference_erased);
+                break;
+            }
+            default:
+                [[maybe_unused]] auto it = checked.find(key);
+                [[maybe_unused]] auto ref = reference.find(key);
+                assert((it == checked.end()) == (ref == reference.end()));
+                assert(it == checked.end() || it->second == ref->second);
+        }
+    }
+    assert(checked.size() == reference.size());
+    size_t iterated = 0;
+    for ([[maybe_unused]] const auto& [key, val] : checked) {
+        assert(reference.at(key) == val);
+        ++iterated;
+    }
+    assert(iterated == reference.size());
+    FlatHashMap<int, int> copy(checked);
+    checked.clear();
+    assert(checked.empty() && copy.size() == reference.size());
+    std::cout << "✅ FlatHashMap: 300000 случайных операций совпадают с std::unordered_map\n";
+
+    // 3. Коэффициент заполнения задаётся при создании
+    FlatHashMap<int, int> sparse(0.5f);
+    for (int i = 0; i < 1000; ++i) {
+        sparse[i] = i;
+    }
+    assert(sparse.load_factor() <= 0.5f && sparse.max_load_factor() == 0.5f);
+    KeyValueStorage<int, int, FlatHashMap<int, int>> sparse_storage(std::move(sparse));
+    assert(sparse_storage.Find(999, &value) && value == 999);
+    std::cout << "✅ FlatHashMap: max_load_factor = 0.5 → load_factor = " << sparse_storage.Data().load_factor() << "\n";
+
+    // 3a. Значение и ключ из самой таблицы переживают рост при вставке
+    {
+        const std::string long_value(64, 'v');
+        KeyValueStorage<std::string, std::string, FlatHashMap<std::string, std::string>> aliased;
+        aliased.Insert("k0", long_value);
+        for (int i = 0; i < 200; ++i) {
+            const std::string key = "new" + std::to_string(i);
+            aliased.Insert(key, *aliased.Lookup("k0"));  // каждое пересечение порога заполнения
+            [[maybe_unused]] const std::string* stored = aliased.Lookup(key);
+            assert(stored && *stored == long_value);
+        }
+        FlatHashMap<std::string, std::string> direct;
+        direct["k0"] = long_value;
+        for (int i = 0; i < 200; ++i) {
+            [[maybe_unused]] auto [it, inserted] = direct.insert_or_assign("new" + std::to_string(i), direct.find("k0")->second);
+            assert(inserted && it->second == long_value);
+            [[maybe_unused]] auto [same, emplaced] = direct.try_emplace("copy" + std::to_string(i), it->second);
+            assert(emplaced && same->second == long_value);
+        }
+    }
+    {
+        FlatHashMap<int, ThrowingCopy> throwing;
+        for (int i = 0; i < 100; ++i) {
+            throwing[i];
+        }
+        copies_until_throw = 50;
+        [[maybe_unused]] bool copy_failed = false;
+        try {
+            FlatHashMap<int, ThrowingCopy> copy(throwing);
+        } catch (const std::runtime_error&) {
+            copy_failed = true;
+        }
+        copies_until_throw = -1;
+        assert(copy_failed && live_throwing_copies == 100);  // частичная копия не утекла
+    }
+    assert(live_throwing_copies == 0);
+    std::cout << "✅ FlatHashMap: вставка ссылки на собственный элемент, копирование с исключением\n";
+
+    // 4. Бенчмарк: std::unordered_map против FlatHashMap
+    const int kKeys = 1000000;
+    std::vector<int> int_keys(kKeys), int_missing(kKeys);
+    for (int i = 0; i < kKeys; ++i) {
+        int_keys[i] = static_cast<int>(rng());
+        int_missing[i] = -static_cast<int>(rng() % 1000000000) - 1;
+    }
+    std::sort(int_keys.begin(), int_keys.end());
+    int_keys.erase(std::unique(int_keys.begin(), int_keys.end()), int_keys.end());
+    int_keys.erase(std::remove_if(int_keys.begin(), int_keys.end(), [](int k) { return k < 0; }), int_keys.end());
+    std::shuffle(int_keys.begin(), int_keys.end(), rng);
+    std::cout << "\n⏱  " << int_keys.size() << " ключей int:\n";
+    Benchmark<KeyValueStorage<int, int>>("std::unordered_map", int_keys, int_missing);
+    Benchmark<KeyValueStorage<int, int, FlatHashMap<int, int>>>("FlatHashMap       ", int_keys, int_missing);
+
+    std::vector<std::string> str_keys, str_missing;
+    for (int i = 0; i < kKeys / 2; ++i) {
+        str_keys.push_back("key:" + std::to_string(i) + ":" + std::to_string(rng()));
+        str_missing.push_back("absent:" + std::to_string(i));
+    }
+    std::cout << "\n⏱  " << str_keys.size() << " ключей std::string:\n";
+    Benchmark<KeyValueStorage<std::string, int>>("std::unordered_map", str_keys, str_missing);
+    Benchmark<KeyValueStorage<std::string, int, FlatHashMap<std::string, int>>>("FlatHashMap       ", str_keys, str_missing);
+
+    // 5. Шардированное хранилище из нескольких потоков
+    ConcurrentKeyValueStorage<int, int> shared(8);
+    {
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&shared, t] {
+                for (int i = t; i < 40000; i += 4) {
+                    shared.Insert(i, i * 2);
+                    if (i % 10 == 0) {
+                        shared.Remove(i);
+                    }
+                }
+            });
+        }
+        for (auto& w : writers) {
+            w.join();
+        }
+    }
+    assert(shared.Size() == 36000);
+    assert(shared.Find(7, &value) && value == 14);
+    assert(!shared.Find(10));
+    std::cout << "✅ ConcurrentKeyValueStorage: 4 потока пишут в 8 шардов\n";
+
+    // 6. Масштабирование: один глобальный мьютекс против шардов
+    auto scaling = [&](const char* name, int write_percent, auto& storage, auto&& insert, auto&& remove, auto&& find) {
+        const unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+        const int kOps = 400000;
+        std::cout << "   " << name << " записи " << write_percent << "%,";
+        for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> pool;
+            for (unsigned t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t] {
+                    std::mt19937 local_rng(t);
+                    int out;
+                    for (int i = 0; i < kOps; ++i) {
+                        int key = static_cast<int>(local_rng() % 100000);
+                        int dice = static_cast<int>(local_rng() % 100);
+                        if (dice < write_percent / 2) {
+                            insert(storage, key, i);
+                        } else if (dice < write_percent) {
+                            remove(storage, key);
+                        } else {
+                            find(storage, key, &out);
+                        }
+                    }
+                });
+            }
+            for (auto& p : pool) {
+                p.join();
+            }
+            std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+            std::cout << "  " << threads << " п. " << std::fixed << threads * kOps / dur.count() / 1e6 << " млн/с";
+            if (threads == max_threads) {
+                break;
+            }
+        }
+        std::cout << '\n';
+    };
+    struct Locked {
+        std::mutex mutex;
+        KeyValueStorage<int, int> storage;
+    };
+    std::cout << "\n⏱  Смешанная нагрузка, 10^5 ключей:\n";
+    for (int write_percent : {5, 50}) {
+        Locked locked;
+        ConcurrentKeyValueStorage<int, int> sharded;
+        ConcurrentKeyValueStorage<int, int, FlatHashMap<int, int>> sharded_flat;
+        for (int i = 0; i < 100000; i += 2) {
+            locked.storage.Insert(i, i);
+            sharded.Insert(i, i);
+            sharded_flat.Insert(i, i);
+        }
+        scaling("глобальный мьютекс:    ", write_percent, locked,
+            [](Locked& l, int k, int v) { std::lock_guard g(l.mutex); l.storage.Insert(k, v); },
+            [](Locked& l, int k) { std::lock_guard g(l.mutex); l.storage.Remove(k); },
+            [](Locked& l, int k, int* v) { std::lock_guard g(l.mutex); return l.storage.Find(k, v); });
+        auto insert = [](auto& st, int k, int v) { st.Insert(k, v); };
+        auto remove = [](auto& st, int k) { st.Remove(k); };
+        auto find = [](auto& st, int k, int* v) { return st.Find(k, v); };
+        scaling("64 × unordered_map:    ", write_percent, sharded, insert, remove, find);
+        scaling("64 × FlatHashMap:      ", write_percent, sharded_flat, insert, remove, find);
+    }
+
+    // 7. Хранилище на диске: журнал, снимок и восстановление
+    namespace fs = std::filesystem;
+    const std::string dir = (fs::temp_directory_path() / "kv_durable_test").string();
+    fs::remove_all(dir);
+    using Durable = DurableKeyValueStorage<std::string, int>;
+    {
+        Durable db(dir);
+        db.Insert("a", 1);
+        db.Insert("b", 2);
+        db.Remove("a");
+        db.Insert("c", 3);
+    }
+    {
+        Durable db(dir);
+        assert(!db.Find("a") && db.Find("b", &value) && value == 2 && db.Find("c"));
+        db.Compact();
+        assert(db.LogSize() == 0);
+        db.Insert("d", 4);
+        db.Remove("b");
+        db.Commit();
+    }
+    {
+        std::FILE* log = std::fopen((dir + "/wal").c_str(), "ab");
+        std::fputs("torn record", log);  // обрыв записи при падении
+        std::fclose(log);
+        Durable db(dir);
+        assert(db.Find("c", &value) && value == 3);
+        assert(db.Find("d", &value) && value == 4);
+        assert(!db.Find("b") && !db.Find("a"));
+        db.Insert("b", 20);
+        db.Compact();
+        db.Insert("e", 5);
+    }
+    {
+        Durable db(dir);
+        assert(db.Find("b", &value) && value == 20);
+        assert(db.Find("e") && db.Find("c") && db.Find("d") && !db.Find("a"));
+    }
+    std::cout << "✅ DurableKeyValueStorage: переживает перезапуск, снимок + хвост журнала, обрыв записи\n";
+
+    // Commit, упавший посреди записи группы, и повтор: в журнале нет обрывка
+    {
+        Durable db(dir, Durable::Options{1000000});
+        for (int i = 0; i < 50; ++i) {
+            db.Insert("group:" + std::to_string(i), i);
+        }
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit old_limit;
+        ::getrlimit(RLIMIT_FSIZE, &old_limit);
+        rlimit small_limit = old_limit;
+        small_limit.rlim_cur = db.LogSize() + 100;  // запишется только начало группы
+        ::setrlimit(RLIMIT_FSIZE, &small_limit);
+        [[maybe_unused]] bool commit_failed = false;
+        try {
+            db.Commit();
+        } catch (const std::system_error&) {
+            commit_failed = true;
+        }
+        ::setrlimit(RLIMIT_FSIZE, &old_limit);
+        std::signal(SIGXFSZ, SIG_DFL);
+        assert(commit_failed);
+        db.Insert("after retry", 1);
+        db.Commit();
+    }
+    {
+        Durable db(dir);
+        for (int i = 0; i < 50; ++i) {
+            assert(db.Find("group:" + std::to_string(i), &value) && value == i);
+        }
+        assert(db.Find("after retry") && db.Find("b") && db.Find("e"));
+    }
+
+    // Смещения из повреждённого снимка проверяются до разыменования
+    {
+        Durable db(dir);
+        db.Compact();
+    }
+    {
+        std::FILE* snapshot_file = std::fopen((dir + "/snapshot").c_str(), "r+b");
+        uint64_t header[4];
+        [[maybe_unused]] const size_t headers_read = std::fread(header, sizeof(header), 1, snapshot_file);
+        assert(headers_read == 1);
+        std::vector<uint64_t> bad_buckets(header[1], ~uint64_t{0});
+        std::fseek(snapshot_file, sizeof(header), SEEK_SET);
+        std::fwrite(bad_buckets.data(), sizeof(uint64_t), bad_buckets.size(), snapshot_file);
+        std::fclose(snapshot_file);
+        Durable db(dir);
+        [[maybe_unused]] bool rejected = false;
+        try {
+            db.Find("c");
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+    fs::remove_all(dir);
+    std::cout << "✅ DurableKeyValueStorage: повтор Commit после сбоя записи, проверка смещений снимка\n";
+
+    // 8. Время старта зависит от хвоста журнала, а не от объёма данных
+    std::cout << "\n⏱  Открытие хранилища после 200000 вставок:\n";
+    auto time_open = [&](const char* name) {
+        auto start = std::chrono::steady_clock::now();
+        Durable db(dir);
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        assert(db.Find("key:199999", &value) && value == 199999);
+        std::cout << "   " << name << ": " << std::fixed << dur.count() * 1000 << " мс\n";
+    };
+    fs::remove_all(dir);
+    {
+        Durable db(dir, Durable::Options{4096});
+        for (int i = 0; i < 200000; ++i) {
+            db.Insert("key:" + std::to_string(i), i);
+        }
+    }
+    time_open("всё в журнале               ");
+    {
+        Durable db(dir);
+        db.Compact();
+        for (int i = 0; i < 1000; ++i) {
+            db.Insert("tail:" + std::to_string(i), i);
+        }
+    }
+    time_open("снимок + 1000 записей журнала");
+    fs::remove_all(dir);
+
+    // 9. Поиск без копирования и без временных ключей
+    KeyValueStorage<std::string, std::string, FlatStringMap<std::string>> docs;
+    const std::string long_key = "a key that is far too long for the small string buffer";
+    docs.Insert(long_key, std::string(4096, 'x'));
+    docs.Insert("short", "value");
+    [[maybe_unused]] size_t allocations_before = heap_allocations;
+    [[maybe_unused]] const std::string* doc = docs.Lookup("a key that is far too long for the small string buffer");
+    [[maybe_unused]] bool found_view = docs.Find(std::string_view(long_key));
+    [[maybe_unused]] bool found_ptr = docs.Find(long_key.c_str());
+    [[maybe_unused]] const std::string* missing_doc = docs.Lookup(std::string_view("missing"));
+    assert(heap_allocations == allocations_before);
+    assert(doc != nullptr && doc->size() == 4096 && found_view && found_ptr && missing_doc == nullptr);
+    assert(*docs.Lookup("short") == "value");
+    KeyValueStorage<std::string, int> plain;
+    plain.Insert("k", 1);
+    assert(plain.Find("k") && *plain.Lookup(std::string_view("k")) == 1);  // без прозрачного хеша ключ строится
+    // У std::unordered_map прозрачный find() есть только с C++20
+    using TransparentUnordered = std::unordered_map<std::string, int, StringHash, std::equal_to<>>;
+    static_assert(HasTransparentLookup<FlatStringMap<int>>::value);
+#ifndef __cpp_lib_generic_unordered_lookup
+    static_assert(!HasTransparentLookup<TransparentUnordered>::value);
+#endif
+    KeyValueStorage<std::string, int, TransparentUnordered> transparent_unordered;
+    transparent_unordered.Insert("k", 2);
+    assert(transparent_unordered.Find(std::string_view("k"), &value) && value == 2 && !transparent_unordered.Find("x"));
+    std::cout << "✅ Lookup/Find по строковому литералу, string_view и const char* без аллокаций\n";
+
+    // 10. Кэш с вытеснением LRU и временем жизни записей
+    LruKeyValueStorage<std::string, int, FakeClock> cache(3);
+    cache.Insert("a", 1);
+    cache.Insert("b", 2);
+    cache.Insert("c", 3);
+    // Find двигает запись в начало очереди и считает попадания, поэтому
+    // вызовы делаются вне assert и не пропадают при NDEBUG
+    [[maybe_unused]] const bool found_a = cache.Find("a");  // теперь самый старый — "b"
+    assert(found_a);
+    cache.Insert("d", 4);
+    [[maybe_unused]] const bool found_b = cache.Find("b"), found_c = cache.Find("c"), found_d = cache.Find("d");
+    assert(cache.Size() == 3 && !found_b && found_c && found_d);
+    cache.Insert("c", 30, std::chrono::milliseconds(100));
+    FakeClock::current += std::chrono::milliseconds(99);
+    [[maybe_unused]] const bool fresh_c = cache.Find("c", &value);
+    assert(fresh_c && value == 30);
+    FakeClock::current += std::chrono::milliseconds(1);
+    [[maybe_unused]] const bool expired_c = cache.Find("c");
+    assert(!expired_c && cache.Size() == 2);
+    cache.Remove("a");
+    cache.Insert("e", 5);
+    cache.Insert("f", 6);
+    [[maybe_unused]] const bool kept_d = cache.Find("d"), kept_e = cache.Find("e"), kept_f = cache.Find("f");
+    assert(cache.Size() == 3 && kept_d && kept_e && kept_f);
+    [[maybe_unused]] const auto& stats = cache.GetStats();
+    assert(stats.hits == 7 && stats.misses == 2 && stats.evictions == 1 && stats.expirations == 1);
+    [[maybe_unused]] size_t cache_allocations = heap_allocations;
+    for (int i = 0; i < 10000; ++i) {
+        cache.Insert("k", i);
+        cache.Find("e");
+    }
+    assert(heap_allocations == cache_allocations && cache.Size() == 3);
+    // Ключ хранится один раз: длинный ключ стоит одну аллокацию, а в узле,
+    // освобождённом вытеснением, буфер старого ключа переиспользуется
+    LruKeyValueStorage<std::string, int> long_keys(1000);
+    std::vector<std::string> long_names(2000);
+    for (size_t i = 0; i < long_names.size(); ++i) {
+        long_names[i] = "a key long enough to live on the heap #" + std::to_string(i + 1000);
+    }
+    cache_allocations = heap_allocations;
+    for (size_t i = 0; i < 1000; ++i) {
+        long_keys.Insert(long_names[i], static_cast<int>(i));
+    }
+    assert(heap_allocations - cache_allocations == 1000);
+    cache_allocations = heap_allocations;
+    for (size_t i = 1000; i < 2000; ++i) {
+        long_keys.Insert(long_names[i], static_cast<int>(i));
+    }
+    assert(heap_allocations == cache_allocations && long_keys.GetStats().evictions == 1000);
+    [[maybe_unused]] const bool newest = long_keys.Find(long_names[1999], &value);
+    [[maybe_unused]] const bool oldest = long_keys.Find(long_names[0]);
+    assert(newest && value == 1999 && !oldest);
+    std::cout << "✅ LruKeyValueStorage: вытеснение, TTL, счётчики, вставки без аллокаций\n";
+
+    // 11. Пакетный поиск и вставка
+    KeyValueStorage<int, int, FlatHashMap<int, int>> batched;
+    KeyValueStorage<int, int> batched_std;
+    std::vector<int> batch_keys(1000), batch_values(1000);
+    for (int i = 0; i < 1000; ++i) {
+        batch_keys[i] = i * 7;
+        batch_values[i] = i;
+    }
+    batched.InsertMany(batch_keys.data(), batch_values.data(), batch_keys.size());
+    batched_std.InsertMany(batch_keys.data(), batch_values.data(), batch_keys.size());
+    std::vector<int> probe_keys = {0, 1, 7, 6993, 7000, 14};
+    std::vector<int> probe_values(probe_keys.size(), -1), probe_values_std(probe_keys.size(), -1);
+    std::unique_ptr<bool[]> probe_found(new bool[probe_keys.size()]), probe_found_std(new bool[probe_keys.size()]);
+    batched.FindMany(probe_keys.data(), probe_keys.size(), probe_values.data(), probe_found.get());
+    batched_std.FindMany(probe_keys.data(), probe_keys.size(), probe_values_std.data(), probe_found_std.get());
+    assert(probe_values == std::vector<int>({0, -1, 1, 999, -1, 2}));
+    assert(probe_values == probe_values_std);
+    for (size_t i = 0; i < probe_keys.size(); ++i) {
+        assert(probe_found[i] == (probe_keys[i] % 7 == 0 && probe_keys[i] < 7000));
+        assert(probe_found[i] == probe_found_std[i]);
+    }
+    std::cout << "✅ FindMany/InsertMany совпадают с поштучными Find/Insert\n";
+
+    std::cout << "\n⏱  Поиск 4·10^6 случайных ключей, по одному и пакетами с prefetch:\n";
+    for (size_t table_size : {size_t{1} << 14, size_t{1} << 23}) {
+        KeyValueStorage<int, int, FlatHashMap<int, int>> table;
+        std::vector<int> table_keys(table_size), table_values(table_size);
+        for (size_t i = 0; i < table_size; ++i) {
+            table_keys[i] = static_cast<int>(rng());
+            table_values[i] = static_cast<int>(i);
+        }
+        table.InsertMany(table_keys.data(), table_values.data(), table_size);
+        std::vector<int> queries(4000000);
+        for (auto& q : queries) {
+            q = table_keys[rng() % table_size];
+        }
+        std::vector<int> results(queries.size());
+        std::unique_ptr<bool[]> found(new bool[queries.size()]);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i) {
+            found[i] = table.Find(queries[i], &results[i]);
+        }
+        std::chrono::duration<double> one_by_one = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        table.FindMany(queries.data(), queries.size(), results.data(), found.get());
+        std::chrono::duration<double> many = std::chrono::steady_clock::now() - start;
+        assert(std::all_of(found.get(), found.get() + queries.size(), [](bool f) { return f; }));
+        std::cout << "   " << table_size << " ключей (" << table.Data().bucket_count() * 9 / 1024 << " КБ): "
+                  << std::fixed << one_by_one.count() << " с → " << many.count() << " с, ускорение "
+                  << one_by_one.count() / many.count() << "x\n";
+    }
+
+    std::cout << "\n⏱  10^6 поисков значений по 4 КБ:\n";
+    std::vector<std::string> doc_keys;
+    for (int i = 0; i < 1000; ++i) {
+        doc_keys.push_back("document:" + std::to_string(i) + ":" + std::string(40, 'k'));
+        docs.Insert(doc_keys.back(), std::string(4096, static_cast<char>('a' + i % 26)));
+    }
+    auto time_lookups = [&](const char* name, auto&& lookup) {
+        size_t allocs = heap_allocations;
+        auto start = std::chrono::steady_clock::now();
+        size_t total = 0;
+        for (int i = 0; i < 1000000; ++i) {
+            total += lookup(doc_keys[i % doc_keys.size()]);
+        }
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        assert(total == 4096 * 1000000ULL);
+        std::cout << "   " << name << ": " << std::fixed << dur.count() << " с, аллокаций " << heap_allocations - allocs << "\n";
+    };
+    time_lookups("Find(std::string(key), &copy)", [&](const std::string& key) {
+        std::string copy;
+        docs.Find(std::string(key.data(), key.size()), &copy);
+        return copy.size();
+    });
+    time_lookups("Lookup(std::string_view)     ", [&](const std::string& key) {
+        return docs.Lookup(std::string_view(key))->size();
+    });
+
+    // 12. Упорядоченный бэкенд на префиксном дереве сверяется с std::map
+    KeyValueStorage<std::string, int, RadixTreeMap<int>> ordered;
+    std::map<std::string, int> ordered_reference;
+    const std::string kPieces[] = {"a", "b", "ab", "\xff", std::string(1, '\0'), "common/prefix/longer/than/eight/"};
+    auto random_key = [&] {
+        std::string key;
+        for (int parts = static_cast<int>(rng() % 5); parts > 0; --parts) {
+            if (rng() % 3) {
+                key += kPieces[rng() % 6];
+            } else {
+                key += static_cast<char>(rng() % 256);  // wide fan-out for Node48/Node256
+            }
+        }
+        return key;
+    };
+    auto check_ordered = [&](const std::string& lo, const std::string& hi) {
+        auto it = ordered_reference.lower_bound(lo);
+        auto found = ordered.LowerBound(std::string_view(lo));
+        assert((it == ordered_reference.end()) == (found == ordered.Data().end()));
+        assert(it == ordered_reference.end() || (found->first == it->first && found->second == it->second));
+        auto expected = it;
+        for ([[maybe_unused]] const auto& [key, val] : ordered.Range(lo, hi)) {
+            assert(expected != ordered_reference.end() && key == expected->first && val == expected->second);
+            ++expected;
+        }
+        assert(lo >= hi ? expected == it : expected == ordered_reference.lower_bound(hi));
+        expected = it;
+        for ([[maybe_unused]] const auto& entry : ordered.PrefixScan(lo)) {
+            assert(expected->first.compare(0, lo.size(), lo) == 0 && entry.first == expected->first);
+            ++expected;
+        }
+        assert(expected == ordered_reference.end() || expected->first.compare(0, lo.size(), lo) != 0);
+    };
+    for (int step = 0; step < 200000; ++step) {
+        std::string key = random_key();
+        switch (rng() % 4) {
+            case 0:
+            case 1:
+                ordered.Insert(key, step);
+                ordered_reference[key] = step;
+                break;
+            case 2:
+                ordered.Remove(key);
+                ordered_reference.erase(key);
+                break;
+            default:
+                [[maybe_unused]] auto it = ordered_reference.find(key);
+                [[maybe_unused]] const int* found = ordered.Lookup(std::string_view(key));
+                assert((it == ordered_reference.end()) == (found == nullptr));
+                assert(found == nullptr || *found == it->second);
+                check_ordered(key, random_key());
+        }
+        if (step % 20000 == 0) {
+            assert(ordered.Data().size() == ordered_reference.size());
+            assert(std::equal(ordered.Data().begin(), ordered.Data().end(), ordered_reference.begin(), ordered_reference.end(),
+                [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; }));
+        }
+    }
+    auto from_find = ordered.Data().find(ordered_reference.begin()->first);
+    assert(std::equal(from_find, ordered.Data().end(), ordered_reference.begin(), ordered_reference.end(),
+        [](const auto& a, const auto& b) { return a.first == b.first; }));
+    RadixTreeMap<int> ordered_copy(ordered.Data());
+    for (const auto& [key, val] : ordered_reference) {
+        ordered.Remove(key);
+    }
+    assert(ordered.Data().empty() && ordered.Data().begin() == ordered.Data().end());
+    assert(ordered_copy.size() == ordered_reference.size());
+    KeyValueStorage<std::string, int, std::map<std::string, int>> sorted_map;
+    sorted_map.Insert("apple", 1);
+    sorted_map.Insert("apricot", 2);
+    sorted_map.Insert("banana", 3);
+    int prefixed = 0;
+    for (const auto& entry : sorted_map.PrefixScan("ap")) {
+        prefixed += entry.second;
+    }
+    assert(prefixed == 3);
+    // У деревьев нечего резервировать: InsertMany просто вставляет по одному
+    const std::string many_keys[] = {"cherry", "apple", "date"};
+    const int many_values[] = {4, 10, 5};
+    sorted_map.InsertMany(many_keys, many_values, 3);
+    KeyValueStorage<std::string, int, RadixTreeMap<int>> tree_many;
+    tree_many.InsertMany(many_keys, many_values, 3);
+    static_assert(!HasReserve<RadixTreeMap<int>>::value && HasReserve<FlatHashMap<int, int>>::value);
+    assert(sorted_map.Find("apple", &value) && value == 10 && tree_many.Find("date", &value) && value == 5);
+    prefixed = 0;
+    for (const auto& entry : sorted_map.PrefixScan("ap")) {
+        prefixed += entry.second;
+    }
+    assert(prefixed == 12);
+    assert(sorted_map.Range(std::string("b"), std::string("a")).begin() == sorted_map.Range(std::string("b"), std::string("a")).end());
+    std::cout << "✅ RadixTreeMap: 200000 случайных операций, LowerBound, Range и PrefixScan совпадают с std::map\n";
+
+    std::cout << "\n⏱  " << str_keys.size() << " ключей std::string, упорядоченные бэкенды:\n";
+    Benchmark<KeyValueStorage<std::string, int, std::map<std::string, int>>>("std::map          ", str_keys, str_missing);
+    Benchmark<KeyValueStorage<std::string, int, RadixTreeMap<int>>>("RadixTreeMap      ", str_keys, str_missing);
+    Benchmark<KeyValueStorage<std::string, int>>("std::unordered_map", str_keys, str_missing);
+
+    std::cout << "\n⏱  10^4 префиксных запросов по " << str_keys.size() << " ключам:\n";
+    {
+        KeyValueStorage<std::string, int, std::map<std::string, int>> by_map;
+        KeyValueStorage<std::string, int, RadixTreeMap<int>> by_tree;
+        KeyValueStorage<std::string, int> by_hash;
+        for (size_t i = 0; i < str_keys.size(); ++i) {
+            by_map.Insert(str_keys[i], static_cast<int>(i));
+            by_tree.Insert(str_keys[i], static_cast<int>(i));
+            by_hash.Insert(str_keys[i], static_cast<int>(i));
+        }
+        // What the hash backend needs for the same queries: a sorted copy of the keys.
+        std::vector<std::string> sorted_keys(str_keys);
+        std::sort(sorted_keys.begin(), sorted_keys.end());
+        std::vector<std::string> prefixes;
+        for (int i = 0; i < 10000; ++i) {
+            prefixes.push_back("key:" + std::to_string(rng() % 50000));
+        }
+        auto time_scans = [&](const char* name, auto&& scan) {
+            auto start = std::chrono::steady_clock::now();
+            int64_t total = 0;
+            size_t entries = 0;
+            for (const auto& prefix : prefixes) {
+                scan(prefix, total, entries);
+            }
+            std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+            std::cout << "   " << name << ": " << std::fixed << dur.count() << " с, " << entries << " записей, сумма " << total << "\n";
+            return total;
+        };
+        auto scan_storage = [](const auto& storage) {
+            return [&storage](const std::string& prefix, int64_t& total, size_t& entries) {
+                for (const auto& entry : storage.PrefixScan(prefix)) {
+                    total += entry.second;
+                    ++entries;
+                }
+            };
+        };
+        [[maybe_unused]] const int64_t map_total = time_scans("std::map                     ", scan_storage(by_map));
+        [[maybe_unused]] const int64_t tree_total = time_scans("RadixTreeMap                 ", scan_storage(by_tree));
+        [[maybe_unused]] const int64_t hash_total = time_scans("хэш + сортированная копия    ", [&](const std::string& prefix, int64_t& total, size_t& entries) {
+            for (auto it = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), prefix);
+                 it != sorted_keys.end() && it->compare(0, prefix.size(), prefix) == 0; ++it) {
+                total += *by_hash.Lookup(*it);
+                ++entries;
+            }
+        });
+        assert(map_total == tree_total && tree_total == hash_total);
+    }
+
+    std::cout << "\n🎉 Все тесты пройдены!\n";
+}
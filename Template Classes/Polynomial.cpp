@@ -1,4 +1,17 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 template<typename T>
@@ -22,13 +35,344 @@ bool operator!=(const Polynomial<T>&, const T&);
 template<typename T>
 bool operator!=(const T&, const Polynomial<T>&);
 
+// Integers modulo a prime Mod < 2^31: a coefficient type with exact
+// arithmetic and division, for Polynomial over a finite field.
+template<uint32_t Mod>
+class Modular {
+private:
+    uint32_t value = 0;
+
+public:
+    static constexpr uint32_t kModulus = Mod;
+
+    constexpr Modular() = default;
+
+    constexpr Modular(int64_t x):
+        value(static_cast<uint32_t>((x % static_cast<int64_t>(Mod) + Mod) % Mod)) {}
+
+    constexpr uint32_t Value() const {
+        return value;
+    }
+
+    constexpr Modular Pow(uint64_t power) const {
+        Modular result(1), base = *this;
+        for (; power; power >>= 1) {
+            if (power & 1) {
+                result *= base;
+            }
+            base *= base;
+        }
+        return result;
+    }
+
+    // Mod is prime, so x^(Mod - 2) is the inverse of x != 0.
+    constexpr Modular Inverse() const {
+        return this->Pow(Mod - 2);
+    }
+
+    constexpr Modular& operator+=(const Modular& other) {
+        value += other.value;
+        if (value >= Mod) value -= Mod;
+        return *this;
+    }
+
+    constexpr Modular& operator-=(const Modular& other) {
+        value += Mod - other.value;
+        if (value >= Mod) value -= Mod;
+        return *this;
+    }
+
+    constexpr Modular& operator*=(const Modular& other) {
+        value = static_cast<uint32_t>(static_cast<uint64_t>(value) * other.value % Mod);
+        return *this;
+    }
+
+    constexpr Modular& operator/=(const Modular& other) {
+        return *this *= other.Inverse();
+    }
+
+    constexpr Modular operator-() const {
+        return Modular() - *this;
+    }
+
+    friend constexpr Modular operator+(Modular a, const Modular& b) {
+        return a += b;
+    }
+
+    friend constexpr Modular operator-(Modular a, const Modular& b) {
+        return a -= b;
+    }
+
+    friend constexpr Modular operator*(Modular a, const Modular& b) {
+        return a *= b;
+    }
+
+    friend constexpr Modular operator/(Modular a, const Modular& b) {
+        return a /= b;
+    }
+
+    friend constexpr bool operator==(const Modular& a, const Modular& b) {
+        return a.value == b.value;
+    }
+
+    friend constexpr bool operator!=(const Modular& a, const Modular& b) {
+        return a.value != b.value;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const Modular& x) {
+        return out << x.value;
+    }
+};
+
+template<typename T>
+struct IsModular : std::false_type {};
+
+template<uint32_t Mod>
+struct IsModular<Modular<Mod>> : std::true_type {};
+
+enum class MultiplicationAlgorithm { kAuto, kSchoolbook, kKaratsuba, kTransform };
+enum class DivisionAlgorithm { kAuto, kLong, kNewton };
+
+inline uint32_t PowMod(uint64_t base, uint64_t power, const uint32_t p) {
+    uint64_t result = 1;
+    for (base %= p; power; power >>= 1) {
+        if (power & 1) result = result * base % p;
+        base = base * base % p;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+// Montgomery multiplication modulo an odd P < 2^30: MulReduce(a, b) is
+// a * b / 2^32 mod P, two multiplies and no division.
+template<uint32_t P>
+struct Montgomery {
+    static constexpr uint32_t NegInverse() {
+        uint32_t inv = P;  // Newton's iteration doubles the correct low bits
+        for (int i = 0; i < 5; ++i) inv *= 2 - P * inv;
+        return 0u - inv;
+    }
+
+    static constexpr uint32_t kNegInverse = NegInverse();
+    static constexpr uint64_t kR2 = (uint64_t{1} << 32) % P * ((uint64_t{1} << 32) % P) % P;  // 2^64 mod P
+
+    static uint32_t MulReduce(const uint32_t a, const uint32_t b) {
+        uint64_t t = static_cast<uint64_t>(a) * b;
+        uint32_t m = static_cast<uint32_t>(t) * kNegInverse;
+        uint32_t r = static_cast<uint32_t>((t + static_cast<uint64_t>(m) * P) >> 32);
+        return r >= P ? r - P : r;
+    }
+
+    // x * 2^32 mod P
+    static uint32_t ToForm(const uint32_t x) {
+        return MulReduce(x, static_cast<uint32_t>(kR2));
+    }
+};
+
+// Number-theoretic transform modulo an NTT-friendly prime P with primitive
+// root 3; a.size() must be a power of two dividing P - 1. Coefficients stay
+// plain residues, only the twiddles are kept in Montgomery form.
+template<uint32_t P>
+void Ntt(std::vector<uint32_t>& a, const bool invert) {
+    using M = Montgomery<P>;
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    // roots[half + k] = w_{2 half}^k for every level, built once.
+    std::vector<uint32_t> roots(std::max<size_t>(n, 2));
+    for (size_t half = 1; half < n; half <<= 1) {
+        uint32_t w = PowMod(3, (P - 1) / (2 * half), P);
+        if (invert) w = PowMod(w, P - 2, P);
+        w = M::ToForm(w);
+        roots[half] = M::ToForm(1);
+        for (size_t k = 1; k < half; ++k) {
+            roots[half + k] = M::MulReduce(roots[half + k - 1], w);
+        }
+    }
+    for (size_t half = 1; half < n; half <<= 1) {
+        for (size_t i = 0; i < n; i += 2 * half) {
+            for (size_t k = 0; k < half; ++k) {
+                uint32_t u = a[i + k];
+                uint32_t v = M::MulReduce(a[i + k + half], roots[half + k]);
+                a[i + k] = u + v >= P ? u + v - P : u + v;
+                a[i + k + half] = u >= v ? u - v : u + P - v;
+            }
+        }
+    }
+    if (invert) {
+        uint32_t inv_n = M::ToForm(PowMod(n, P - 2, P));
+        for (auto& x : a) x = M::MulReduce(x, inv_n);
+    }
+}
+
+// Linear (not cyclic) product of residue vectors modulo P.
+template<uint32_t P>
+std::vector<uint32_t> NttMultiply(std::vector<uint32_t> a, std::vector<uint32_t> b) {
+    const size_t result_size = a.size() + b.size() - 1;
+    size_t n = 1;
+    while (n < result_size) n <<= 1;
+    a.resize(n);
+    b.resize(n);
+    Ntt<P>(a, false);
+    Ntt<P>(b, false);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = Montgomery<P>::MulReduce(a[i], Montgomery<P>::ToForm(b[i]));
+    }
+    Ntt<P>(a, true);
+    a.resize(result_size);
+    return a;
+}
+
+// NTT primes for exact products, largest first: all have 3 as a primitive
+// root and support transforms up to 2^23 points. A product is rebuilt by CRT
+// from its residues modulo the first k primes, which is exact while its
+// coefficients are below kCrtModulus[k - 1] / 2 in magnitude.
+constexpr uint32_t kNttPrimes[3] = {998244353, 469762049, 167772161};
+constexpr size_t kMaxNttSize = size_t{1} << 23;
+const long double kCrtModulus[3] = {998244353.0L, 998244353.0L * 469762049.0L,
+                                    998244353.0L * 469762049.0L * 167772161.0L};
+
+// Modular<998244353> products need a single NTT and no CRT.
+template<typename T>
+constexpr bool kIsNttModular = false;
+
+template<uint32_t Mod>
+constexpr bool kIsNttModular<Modular<Mod>> = Mod == kNttPrimes[0];
+
+// Garner's algorithm: the unique x < p0 * ... * p{count-1} with x = r[k] mod p_k,
+// as mixed-radix digits x = d[0] + p0 (d[1] + p1 d[2]) with d[k] < p_k. Three
+// primes need ~90 bits, so x itself is never formed; the helpers below read
+// what the caller needs off the digits in 64-bit arithmetic.
+inline void CrtDigits(const uint32_t* r, const int count, uint64_t* d) {
+    const uint64_t p0 = kNttPrimes[0], p1 = kNttPrimes[1], p2 = kNttPrimes[2];
+    static const uint64_t inv_p0_mod_p1 = PowMod(p0, p1 - 2, static_cast<uint32_t>(p1));
+    static const uint64_t inv_p0p1_mod_p2 = PowMod(p0 * p1 % p2, p2 - 2, static_cast<uint32_t>(p2));
+    d[0] = r[0];
+    d[1] = d[2] = 0;
+    if (count == 1) return;
+    d[1] = (r[1] + p1 - r[0] % p1) % p1 * inv_p0_mod_p1 % p1;
+    if (count == 2) return;
+    const uint64_t x01 = r[0] + p0 * d[1];  // < p0 * p1 < 2^64
+    d[2] = (r[2] + p2 - x01 % p2) % p2 * inv_p0p1_mod_p2 % p2;
+}
+
+// x mod 2^64
+inline uint64_t CrtWrap(const uint64_t* d) {
+    const uint64_t p0 = kNttPrimes[0], p1 = kNttPrimes[1];
+    return d[0] + p0 * d[1] + p0 * p1 * d[2];
+}
+
+// x mod m, for m < 2^32
+inline uint64_t CrtMod(const uint64_t* d, const uint64_t m) {
+    const uint64_t p0 = kNttPrimes[0] % m, p0p1 = p0 * (kNttPrimes[1] % m) % m;
+    return (d[0] % m + p0 * (d[1] % m) % m + p0p1 * (d[2] % m) % m) % m;
+}
+
+// x > (p0 * ... * p{count-1}) / 2. The primes are odd, so half the modulus
+// has the digits (p_k - 1) / 2 and the digits compare from the top.
+inline bool CrtAboveHalf(const uint64_t* d, const int count) {
+    for (int k = count - 1; k >= 0; k--) {
+        const uint64_t half = (kNttPrimes[k] - 1) / 2;
+        if (d[k] != half) return d[k] > half;
+    }
+    return false;
+}
+
+// Complex FFT; a.size() must be a power of two.
+template<typename F>
+void Fft(std::vector<std::complex<F>>& a, const bool invert) {
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    // Only the top level calls cos/sin; lower levels reuse every other
+    // root, so each root carries a single rounding error.
+    const F pi = std::acos(F(-1));
+    std::vector<std::complex<F>> roots(std::max<size_t>(n, 2));
+    for (size_t k = 0; k < n / 2; ++k) {
+        F angle = 2 * pi * static_cast<F>(k) / static_cast<F>(n) * (invert ? -1 : 1);
+        roots[n / 2 + k] = std::complex<F>(std::cos(angle), std::sin(angle));
+    }
+    for (size_t k = n / 2; k-- > 1;) {
+        roots[k] = roots[2 * k];
+    }
+    for (size_t half = 1; half < n; half <<= 1) {
+        for (size_t i = 0; i < n; i += 2 * half) {
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<F> u = a[i + k], v = a[i + k + half] * roots[half + k];
+                a[i + k] = u + v;
+                a[i + k + half] = u - v;
+            }
+        }
+    }
+    if (invert) {
+        for (auto& x : a) x /= static_cast<F>(n);
+    }
+}
+
+// Marks the lazy expression nodes built by Polynomial's +, - and scaling
+// (defined after the class).
+template<typename E>
+struct IsPolynomialExpr : std::false_type {};
+
 template<typename T>
 class Polynomial {
 private:
     std::vector<T> coefficients;
     static const T zero;
 
+    // Below kKaratsubaThreshold coefficients in the shorter factor the
+    // schoolbook loop wins; from kTransformThreshold on an NTT/FFT product
+    // beats Karatsuba (sooner for a single-prime modular NTT, whose rival
+    // Karatsuba pays a division per multiply). Measured by the benchmarks
+    // in main().
+    static constexpr size_t kKaratsubaThreshold = 64;
+    static constexpr size_t kTransformThreshold = kIsNttModular<T> ? 256 : 1024;
+
     void Normalize();
+
+    // out[0, n + m - 1) += a * b
+    static void MultiplySchoolbook(const T* a, size_t n, const T* b, size_t m, T* out);
+    static void MultiplyKaratsuba(const T* a, size_t n, const T* b, size_t m, T* out);
+    // false when no transform is exact for this T or these coefficients
+    static bool MultiplyTransform(const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& out);
+
+    // Subproduct-tree evaluation pays off for exact (Modular) coefficients
+    // from this degree and batch size on; its leaves hold kTreeBlock points
+    // finished off by Horner. In floating point the tree's remainders are
+    // numerically unstable, so floating T always uses Horner.
+    static constexpr int kSubproductTreeDegree = 512;
+    static constexpr size_t kTreeBlock = 64;
+
+    // Newton inversion beats long division once the divisor has degree
+    // kNewtonDivisionThreshold and the quotient at least kNewtonQuotientSize
+    // coefficients; with the inverse precomputed by a Reducer, Newton wins
+    // from divisor degree kNewtonReductionThreshold on (all three measured in
+    // main()). Over the integers the series inverse of the divisor grows
+    // exponentially and overflows, so they always divide long-hand.
+    static constexpr int kNewtonDivisionThreshold =
+        std::is_integral_v<T> ? std::numeric_limits<int>::max() : 1024;
+    static constexpr size_t kNewtonQuotientSize = 128;
+    static constexpr int kNewtonReductionThreshold =
+        std::is_integral_v<T> ? std::numeric_limits<int>::max() : 512;
+
+    // 1 / x; over the integers only +-1 qualify, anything else throws.
+    static T InverseUnit(const T& x);
+    // First n terms of 1 / f as a power series; f[0] must be invertible.
+    static std::vector<T> InverseSeries(const std::vector<T>& f, size_t n);
+    // Quotient by the divisor whose reversal has the power series inverse
+    // `inverse` (at least quotient_size terms): rev(q) = rev(*this) * inverse.
+    Polynomial<T> NewtonQuotient(const std::vector<T>& inverse, size_t quotient_size) const;
+    // *this - quotient * divisor, cut below the divisor's degree
+    Polynomial<T> Remainder(const Polynomial<T>& quotient, const Polynomial<T>& divisor) const;
+    void EvaluateHorner(const T* xs, size_t count, T* out) const;
+    void EvaluateSubproductTree(const T* xs, size_t count, T* out) const;
 public:
     Polynomial() = default;
     Polynomial(const std::vector<T>&);
@@ -39,6 +383,12 @@ public:
     Polynomial(Polynomial<T>&& other);
     void operator=(const Polynomial<T>& other);
     void operator=(Polynomial<T>&& other);
+    // Evaluate an expression into one buffer; assignment reuses this one
+    // even when the expression refers to *this.
+    template<typename E, typename = std::enable_if_t<IsPolynomialExpr<E>::value>>
+    Polynomial(const E& expr);
+    template<typename E, typename = std::enable_if_t<IsPolynomialExpr<E>::value>>
+    void operator=(const E& expr);
     ~Polynomial<T>() = default;
 
     int Degree() const;
@@ -52,6 +402,8 @@ public:
 
     const T& operator [](int i) const;
     T operator()(const T& value) const;
+    // out[i] = (*this)(xs[i]) for i < count
+    void Evaluate(const T* xs, size_t count, T* out) const;
 
     Polynomial<T>& operator +=(const Polynomial<T>& other);
     Polynomial<T>& operator +=(const T& other);
@@ -59,6 +411,16 @@ public:
     Polynomial<T>& operator -=(const T& other);
     Polynomial<T>& operator *=(const Polynomial<T>& other);
     Polynomial<T>& operator *=(const T& other);
+    Polynomial<T>& Multiply(const Polynomial<T>& other, MultiplicationAlgorithm algorithm);
+    Polynomial<T>& operator /=(const Polynomial<T>& other);
+    Polynomial<T>& operator %=(const Polynomial<T>& other);
+    // (quotient, remainder); throws std::domain_error for a zero divisor or,
+    // over the integers, a divisor whose leading coefficient is not +-1.
+    std::pair<Polynomial<T>, Polynomial<T>> DivMod(const Polynomial<T>& divisor) const;
+    // Over the integers kNewton falls back to long division.
+    std::pair<Polynomial<T>, Polynomial<T>> DivMod(const Polynomial<T>& divisor, DivisionAlgorithm algorithm) const;
+
+    class Reducer;
 
     typename std::vector<T>::const_iterator begin() const;
     typename std::vector<T>::reverse_iterator rbegin();
@@ -89,284 +451,1615 @@ Polynomial<T>::Polynomial(const std::vector<T>& coef):
 };
 
 template<typename T>
-Polynomial<T>::Polynomial(const T& coef):
-    coefficients({coef})
+Polynomial<T>::Polynomial(const T& coef):
+    coefficients({coef})
+{
+    this->Normalize();
+};
+
+template<typename T>
+template<typename Iter>
+Polynomial<T>::Polynomial(Iter first, Iter second) {
+    while(first != second) {
+        coefficients.push_back(*first++);
+    }
+    this->Normalize();
+}
+
+template<typename T>
+Polynomial<T>::Polynomial(const Polynomial<T>& other):
+    coefficients(other.coefficients)
+{
+    this->Normalize();
+};
+
+template<typename T>
+Polynomial<T>::Polynomial(Polynomial<T>&& other):
+    coefficients(std::move(other.coefficients))
+{
+    this->Normalize();
+    other.coefficients.clear();  
+};
+
+template<typename T>
+void Polynomial<T>::operator=(const Polynomial<T>& other) {
+    this->coefficients = other.coefficients;
+}
+
+template<typename T>
+void Polynomial<T>::operator=(Polynomial<T>&& other) {
+    this->coefficients = std::move(other.coefficients);
+    other.coefficients.clear();
+}
+
+template<typename T>
+template<typename E, typename>
+Polynomial<T>::Polynomial(const E& expr):
+    coefficients(expr.Size())
+{
+    for (size_t i = 0; i < this->coefficients.size(); i++) {
+        this->coefficients[i] = expr.Coefficient(i);
+    }
+    this->Normalize();
+}
+
+template<typename T>
+template<typename E, typename>
+void Polynomial<T>::operator=(const E& expr) {
+    // Coefficient i of an expression reads only coefficient i of each
+    // operand, so evaluating in place is safe if *this is one of them.
+    const size_t size = expr.Size();
+    this->coefficients.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        this->coefficients[i] = expr.Coefficient(i);
+    }
+    this->Normalize();
+}
+
+template<typename T>
+int Polynomial<T>::Degree() const {
+    return static_cast<int>(coefficients.size()) - 1;
+}
+
+template<typename T>
+bool operator ==(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
+    return poly1.coefficients == poly2.coefficients;
+}
+
+template<typename T>
+bool operator ==(const Polynomial<T>& poly1, const T& poly2) {
+    if (poly1.Degree() == -1 && poly2 == T{}) return true;
+    return (poly1.Degree() == 0 && poly1[0] == poly2);
+}
+
+template<typename T>
+bool operator ==(const T& poly1, const Polynomial<T>& poly2) {
+    if (poly2.Degree() == -1 && poly1 == T{}) return true;
+    return (poly2.Degree() == 0 && poly2[0] == poly1);
+}
+
+template<typename T>
+bool operator !=(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
+    return !(poly1 == poly2);
+}
+
+template<typename T>
+bool operator !=(const Polynomial<T>& poly1, const T& poly2) {
+    return !(poly1 == poly2);
+}
+
+template<typename T>
+bool operator !=(const T& poly1, const Polynomial<T>& poly2) {
+    return !(poly1 == poly2);
+}
+
+template<typename T>
+const T& Polynomial<T>::operator[](int i) const {
+    if (i < 0 || i > this->Degree()) {
+        return Polynomial<T>::zero;
+    }
+    return coefficients[i];
+}
+
+template<typename T>
+T Polynomial<T>::operator()(const T& value) const {
+    if (this->Degree() == -1) return T{};
+    T result = this->coefficients.back();
+    for (auto it = std::next(this->coefficients.rbegin()); it != this->coefficients.rend(); it++) {
+        result = result * value + *it;
+    }
+    return result;
+}
+
+template<typename T>
+void Polynomial<T>::EvaluateHorner(const T* xs, size_t count, T* out) const {
+    const int degree = this->Degree();
+    size_t i = 0;
+    if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+        // Horner across points: every chain is serial in the degree, so
+        // kChains independent vectors of points keep the multiplier busy.
+        typedef T Vector __attribute__((vector_size(16)));
+        constexpr size_t kLanes = sizeof(Vector) / sizeof(T), kChains = 8, kBlock = kLanes * kChains;
+        const T* c = this->coefficients.data();
+        for (; degree >= 0 && i + kBlock <= count; i += kBlock) {
+            Vector x[kChains], acc[kChains];
+            for (size_t k = 0; k < kChains; k++) {
+                __builtin_memcpy(&x[k], xs + i + k * kLanes, sizeof(Vector));
+                acc[k] = Vector{} + c[degree];
+            }
+            for (int d = degree - 1; d >= 0; d--) {
+                for (size_t k = 0; k < kChains; k++) {
+                    acc[k] = acc[k] * x[k] + c[d];
+                }
+            }
+            __builtin_memcpy(out + i, acc, sizeof(acc));
+        }
+    }
+    for (; i < count; i++) {
+        out[i] = (*this)(xs[i]);
+    }
+}
+
+template<typename T>
+T Polynomial<T>::InverseUnit(const T& x) {
+    if constexpr (std::is_integral_v<T>) {
+        if (x != T(1) && x != static_cast<T>(T{} - T(1))) {
+            throw std::domain_error("Leading coefficient is not invertible!");
+        }
+        return x;
+    } else {
+        return T(1) / x;
+    }
+}
+
+template<typename T>
+std::vector<T> Polynomial<T>::InverseSeries(const std::vector<T>& f, size_t n) {
+    auto truncated_product = [](const std::vector<T>& a, const std::vector<T>& b, size_t len) {
+        std::vector<T> product = (Polynomial<T>(a) * Polynomial<T>(b)).coefficients;
+        product.resize(len);
+        return product;
+    };
+    // Newton's iteration g <- g (2 - f g) doubles the number of correct terms.
+    std::vector<T> g{InverseUnit(f[0])};
+    for (size_t len = 1; len < n;) {
+        len = std::min(2 * len, n);
+        std::vector<T> error = truncated_product(std::vector<T>(f.begin(), f.begin() + std::min(len, f.size())), g, len);
+        for (auto& c : error) c = T{} - c;
+        error[0] += T(2);
+        g = truncated_product(g, error, len);
+    }
+    g.resize(n);
+    return g;
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::NewtonQuotient(const std::vector<T>& inverse, size_t quotient_size) const {
+    // Reversed, a = q b + r reads rev(a) = rev(q) rev(b) mod x^quotient_size.
+    std::vector<T> rev(this->coefficients.rbegin(), this->coefficients.rbegin() + quotient_size);
+    std::vector<T> quotient = (Polynomial<T>(rev) *
+                               Polynomial<T>(inverse.begin(), inverse.begin() + quotient_size)).coefficients;
+    quotient.resize(quotient_size);
+    std::reverse(quotient.begin(), quotient.end());
+    return Polynomial<T>(quotient);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::Remainder(const Polynomial<T>& quotient, const Polynomial<T>& divisor) const {
+    Polynomial<T> remainder = *this - quotient * divisor;
+    // The top coefficients cancel exactly only in exact arithmetic.
+    if (remainder.Degree() >= divisor.Degree()) {
+        remainder.coefficients.resize(divisor.Degree());
+        remainder.Normalize();
+    }
+    return remainder;
+}
+
+template<typename T>
+std::pair<Polynomial<T>, Polynomial<T>> Polynomial<T>::DivMod(const Polynomial<T>& divisor) const {
+    return this->DivMod(divisor, DivisionAlgorithm::kAuto);
+}
+
+template<typename T>
+std::pair<Polynomial<T>, Polynomial<T>> Polynomial<T>::DivMod(const Polynomial<T>& divisor, DivisionAlgorithm algorithm) const {
+    const int n = this->Degree(), m = divisor.Degree();
+    if (m == -1) {
+        throw std::domain_error("Division by zero polynomial!");
+    }
+    const T lead_inverse = InverseUnit(divisor.coefficients.back());
+    if (n < m) {
+        return {Polynomial<T>(), *this};
+    }
+    const size_t quotient_size = n - m + 1;
+    if (algorithm == DivisionAlgorithm::kAuto) {
+        algorithm = m < kNewtonDivisionThreshold || quotient_size < kNewtonQuotientSize ? DivisionAlgorithm::kLong
+                                                                                      : DivisionAlgorithm::kNewton;
+    }
+    if (algorithm == DivisionAlgorithm::kLong || std::is_integral_v<T>) {
+        std::vector<T> remainder(this->coefficients), quotient(quotient_size);
+        for (size_t i = quotient_size; i-- > 0;) {
+            quotient[i] = remainder[i + m] * lead_inverse;
+            for (int j = 0; j < m; j++) {
+                remainder[i + j] -= quotient[i] * divisor.coefficients[j];
+            }
+        }
+        remainder.resize(m);
+        return {Polynomial<T>(quotient), Polynomial<T>(remainder)};
+    }
+    std::vector<T> rev_divisor(divisor.coefficients.rbegin(), divisor.coefficients.rend());
+    Polynomial<T> quotient = this->NewtonQuotient(InverseSeries(rev_divisor, quotient_size), quotient_size);
+    Polynomial<T> remainder = this->Remainder(quotient, divisor);
+    return {std::move(quotient), std::move(remainder)};
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator/=(const Polynomial<T>& other) {
+    *this = this->DivMod(other).first;
+    return *this;
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator%=(const Polynomial<T>& other) {
+    *this = this->DivMod(other).second;
+    return *this;
+}
+
+// Reduces polynomials modulo one divisor over and over: the power series
+// inverse of the reversed divisor is computed once, so a reduction of a
+// product of two remainders costs two multiplications.
+template<typename T>
+class Polynomial<T>::Reducer {
+private:
+    Polynomial<T> divisor;
+    std::vector<T> inverse;
+    int max_degree = 0;  // dividends up to this degree take one step; 0 divides long-hand
+
+public:
+    // kAuto picks Newton from kNewtonReductionThreshold on; over the
+    // integers Reduce always divides long-hand.
+    explicit Reducer(const Polynomial<T>& divisor, DivisionAlgorithm algorithm = DivisionAlgorithm::kAuto);
+
+    const Polynomial<T>& Divisor() const;
+    Polynomial<T> Reduce(const Polynomial<T>& poly) const;
+};
+
+template<typename T>
+Polynomial<T>::Reducer::Reducer(const Polynomial<T>& divisor, DivisionAlgorithm algorithm):
+    divisor(divisor)
+{
+    const int m = divisor.Degree();
+    if (m == -1) {
+        throw std::domain_error("Division by zero polynomial!");
+    }
+    InverseUnit(divisor.coefficients.back());
+    if (algorithm == DivisionAlgorithm::kAuto) {
+        algorithm = m < kNewtonReductionThreshold ? DivisionAlgorithm::kLong : DivisionAlgorithm::kNewton;
+    }
+    if (algorithm == DivisionAlgorithm::kNewton && !std::is_integral_v<T> && m > 1) {
+        max_degree = 2 * m - 2;
+        std::vector<T> rev_divisor(divisor.coefficients.rbegin(), divisor.coefficients.rend());
+        inverse = InverseSeries(rev_divisor, max_degree - m + 1);
+    }
+}
+
+template<typename T>
+const Polynomial<T>& Polynomial<T>::Reducer::Divisor() const {
+    return divisor;
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::Reducer::Reduce(const Polynomial<T>& poly) const {
+    const int m = divisor.Degree();
+    if (max_degree == 0) {
+        return poly.DivMod(divisor, DivisionAlgorithm::kLong).second;
+    }
+    // Longer dividends are reduced from the top, max_degree + 1
+    // coefficients at a time.
+    Polynomial<T> result(poly);
+    while (result.Degree() >= m) {
+        const size_t shift = std::max(0, result.Degree() - max_degree);
+        Polynomial<T> window(result.coefficients.begin() + shift, result.coefficients.end());
+        Polynomial<T> remainder = window.Remainder(window.NewtonQuotient(inverse, window.Degree() - m + 1), divisor);
+        result.coefficients.resize(shift);
+        result.coefficients.resize(shift + m);
+        std::copy(remainder.begin(), remainder.end(), result.coefficients.begin() + shift);
+        result.Normalize();
+    }
+    return result;
+}
+
+template<typename T>
+void Polynomial<T>::EvaluateSubproductTree(const T* xs, size_t count, T* out) const {
+    // tree[0] holds the products of (x - x_i) over blocks of kTreeBlock
+    // points, tree[k + 1] the pairwise products of tree[k]; an odd node out
+    // moves up unchanged.
+    std::vector<std::vector<Polynomial<T>>> tree(1);
+    for (size_t i = 0; i < count; i += kTreeBlock) {
+        Polynomial<T> block(T(1));
+        for (size_t j = i; j < std::min(count, i + kTreeBlock); j++) {
+            block *= Polynomial<T>(std::vector<T>{T{} - xs[j], T(1)});
+        }
+        tree[0].push_back(std::move(block));
+    }
+    while (tree.back().size() > 1) {
+        const auto& level = tree.back();
+        std::vector<Polynomial<T>> next;
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            next.push_back(level[i] * level[i + 1]);
+        }
+        if (level.size() % 2) next.push_back(level.back());
+        tree.push_back(std::move(next));
+    }
+    // p mod node for every node, top down; p mod (x - x_i) = p(x_i), and
+    // below the blocks Horner on the small remainder is cheaper.
+    std::vector<Polynomial<T>> remainders{*this % tree.back()[0]};
+    for (size_t k = tree.size() - 1; k-- > 0;) {
+        std::vector<Polynomial<T>> next;
+        for (size_t i = 0; i < tree[k].size(); i++) {
+            next.push_back(remainders[i / 2] % tree[k][i]);
+        }
+        remainders = std::move(next);
+    }
+    for (size_t i = 0; i < remainders.size(); i++) {
+        const size_t first = i * kTreeBlock;
+        remainders[i].EvaluateHorner(xs + first, std::min(kTreeBlock, count - first), out + first);
+    }
+}
+
+template<typename T>
+void Polynomial<T>::Evaluate(const T* xs, size_t count, T* out) const {
+    if constexpr (IsModular<T>::value) {
+        if (this->Degree() >= kSubproductTreeDegree && count >= static_cast<size_t>(kSubproductTreeDegree)) {
+            // One tree per chunk of about deg + 1 points keeps the root's
+            // degree, and so the first division, matched to p.
+            size_t chunk = kTreeBlock;
+            while (chunk <= static_cast<size_t>(this->Degree())) chunk <<= 1;
+            for (size_t i = 0; i < count; i += chunk) {
+                this->EvaluateSubproductTree(xs + i, std::min(chunk, count - i), out + i);
+            }
+            return;
+        }
+    }
+    this->EvaluateHorner(xs, count, out);
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator+=(const Polynomial<T>& other) {
+    this->coefficients.resize(std::max(this->Degree() + 1, other.Degree() + 1));
+    for (int i = 0; i <= other.Degree(); i++) {
+        this->coefficients[i] += other.coefficients[i];
+    }
+    this->Normalize();
+    return *this;
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator+=(const T& other) {
+    this->coefficients.resize(std::max(this->Degree() + 1, 1));
+    this->coefficients[0] += other;
+    this->Normalize();
+    return *this;
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator-=(const Polynomial<T>& other) {
+    this->coefficients.resize(std::max(this->Degree() + 1, other.Degree() + 1));
+    for (int i = 0; i <= other.Degree(); i++) {
+        this->coefficients[i] -= other.coefficients[i];
+    }
+    this->Normalize();
+    return *this;
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator-=(const T& other) {
+    this->coefficients.resize(std::max(this->Degree() + 1, 1));
+    this->coefficients[0] -= other;
+    this->Normalize();
+    return *this;
+}
+
+template<typename T>
+void Polynomial<T>::MultiplySchoolbook(const T* a, size_t n, const T* b, size_t m, T* out) {
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            out[i + j] += a[j] * b[i];
+        }
+    }
+}
+
+template<typename T>
+void Polynomial<T>::MultiplyKaratsuba(const T* a, size_t n, const T* b, size_t m, T* out) {
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (m < kKaratsubaThreshold) {
+        MultiplySchoolbook(a, n, b, m, out);
+        return;
+    }
+    if (n >= 2 * m) {
+        // Unbalanced: cut the longer factor into m-sized slices.
+        for (size_t i = 0; i < n; i += m) {
+            MultiplyKaratsuba(a + i, std::min(m, n - i), b, m, out + i);
+        }
+        return;
+    }
+    // a = a0 + x^h a1, b = b0 + x^h b1; n < 2m guarantees m >= h.
+    const size_t h = (n + 1) / 2;
+    std::vector<T> low(2 * h - 1), high(m > h ? n + m - 2 * h - 1 : 0), middle(2 * h - 1), sum_a(a, a + h), sum_b(b, b + h);
+    for (size_t i = h; i < n; i++) sum_a[i - h] += a[i];
+    for (size_t i = h; i < m; i++) sum_b[i - h] += b[i];
+    MultiplyKaratsuba(a, h, b, h, low.data());
+    if (m > h) {
+        MultiplyKaratsuba(a + h, n - h, b + h, m - h, high.data());
+    }
+    MultiplyKaratsuba(sum_a.data(), h, sum_b.data(), h, middle.data());
+    for (size_t i = 0; i < low.size(); i++) {
+        middle[i] -= low[i];
+        out[i] += low[i];
+    }
+    if (m > h) {
+        for (size_t i = 0; i < high.size(); i++) {
+            middle[i] -= high[i];
+            out[2 * h + i] += high[i];
+        }
+    }
+    // With m == h the top coefficient of middle is zero and lies past out.
+    for (size_t i = 0; i < std::min(middle.size(), n + m - 1 - h); i++) {
+        out[h + i] += middle[i];
+    }
+}
+
+template<typename T>
+bool Polynomial<T>::MultiplyTransform(const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& out) {
+    const size_t result_size = a.size() + b.size() - 1;
+    if constexpr (std::is_floating_point_v<T>) {
+        // Work in at least double precision; the rounding error of each
+        // coefficient stays within ~eps * log2(n) * max|a| * max|b| * n.
+        using F = std::conditional_t<(sizeof(T) > sizeof(double)), T, double>;
+        size_t n = 1;
+        while (n < result_size) n <<= 1;
+        std::vector<std::complex<F>> fa(a.begin(), a.end()), fb(b.begin(), b.end());
+        fa.resize(n);
+        fb.resize(n);
+        Fft(fa, false);
+        Fft(fb, false);
+        for (size_t i = 0; i < n; i++) fa[i] *= fb[i];
+        Fft(fa, true);
+        out.resize(result_size);
+        for (size_t i = 0; i < result_size; i++) out[i] = static_cast<T>(fa[i].real());
+        return true;
+    } else if constexpr (std::is_integral_v<T> || IsModular<T>::value) {
+        // min(n, m) * max|a| * max|b| bounds every coefficient of the true
+        // integer product; it picks how many primes make the CRT exact.
+        auto magnitude = [](const T& x) -> long double {
+            if constexpr (IsModular<T>::value) {
+                return x.Value();
+            } else if constexpr (std::is_signed_v<T>) {
+                return std::fabs(static_cast<long double>(x));
+            } else {
+                return static_cast<long double>(x);
+            }
+        };
+        long double max_a = 0, max_b = 0;
+        for (const auto& x : a) max_a = std::max(max_a, magnitude(x));
+        for (const auto& x : b) max_b = std::max(max_b, magnitude(x));
+        const long double bound = max_a * max_b * static_cast<long double>(std::min(a.size(), b.size()));
+        int primes = 1;
+        while (primes <= 3 && bound >= kCrtModulus[primes - 1] / 2) primes++;
+        if constexpr (kIsNttModular<T>) {
+            primes = 1;  // residues modulo the first NTT prime are the answer
+        }
+        if (result_size > kMaxNttSize || primes > 3) {
+            return false;
+        }
+        auto residues_mod = [&a, &b](auto prime) {
+            constexpr uint32_t p = decltype(prime)::value;
+            auto reduce = [](const T& x) -> uint32_t {
+                if constexpr (IsModular<T>::value) {
+                    return x.Value() % p;
+                } else if constexpr (std::is_signed_v<T>) {
+                    int64_t r = static_cast<int64_t>(x) % static_cast<int64_t>(p);
+                    return static_cast<uint32_t>(r < 0 ? r + p : r);
+                } else {
+                    return static_cast<uint32_t>(static_cast<uint64_t>(x) % p);
+                }
+            };
+            std::vector<uint32_t> ra(a.size()), rb(b.size());
+            std::transform(a.begin(), a.end(), ra.begin(), reduce);
+            std::transform(b.begin(), b.end(), rb.begin(), reduce);
+            return NttMultiply<p>(std::move(ra), std::move(rb));
+        };
+        std::vector<uint32_t> residues[3];
+        residues[0] = residues_mod(std::integral_constant<uint32_t, kNttPrimes[0]>());
+        if (primes > 1) residues[1] = residues_mod(std::integral_constant<uint32_t, kNttPrimes[1]>());
+        if (primes > 2) residues[2] = residues_mod(std::integral_constant<uint32_t, kNttPrimes[2]>());
+        uint64_t modulus_wrap = 1;  // the CRT modulus mod 2^64
+        for (int k = 0; k < primes; k++) modulus_wrap *= kNttPrimes[k];
+        out.resize(result_size);
+        for (size_t i = 0; i < result_size; i++) {
+            const uint32_t r[3] = {residues[0][i], primes > 1 ? residues[1][i] : 0, primes > 2 ? residues[2][i] : 0};
+            uint64_t d[3];
+            CrtDigits(r, primes, d);
+            if constexpr (IsModular<T>::value) {
+                out[i] = T(static_cast<int64_t>(CrtMod(d, T::kModulus)));
+            } else {
+                // Values above modulus / 2 stand for negatives. Both are taken
+                // mod 2^64, and the cast wraps exactly like the schoolbook loop
+                // does for unsigned T.
+                const uint64_t x = CrtWrap(d);
+                out[i] = static_cast<T>(CrtAboveHalf(d, primes) ? x - modulus_wrap : x);
+            }
+        }
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::Multiply(const Polynomial<T>& other, MultiplicationAlgorithm algorithm) {
+    if (this->Degree() == -1 || other.Degree() == -1) {
+        this->coefficients.resize(0);
+        return *this;
+    }
+    const size_t n = this->coefficients.size(), m = other.coefficients.size();
+    if (algorithm == MultiplicationAlgorithm::kAuto) {
+        const size_t shorter = std::min(n, m);
+        algorithm = shorter < kKaratsubaThreshold ? MultiplicationAlgorithm::kSchoolbook
+                  : shorter < kTransformThreshold ? MultiplicationAlgorithm::kKaratsuba
+                  : MultiplicationAlgorithm::kTransform;
+    }
+    std::vector<T> tmp;
+    if (algorithm != MultiplicationAlgorithm::kTransform ||
+        !MultiplyTransform(this->coefficients, other.coefficients, tmp)) {
+        tmp.assign(n + m - 1, T{});
+        if (algorithm == MultiplicationAlgorithm::kSchoolbook) {
+            MultiplySchoolbook(this->coefficients.data(), n, other.coefficients.data(), m, tmp.data());
+        } else {
+            MultiplyKaratsuba(this->coefficients.data(), n, other.coefficients.data(), m, tmp.data());
+        }
+    }
+    this->coefficients = std::move(tmp);
+    this->Normalize();
+    return *this;
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator*=(const Polynomial<T>& other) {
+    return this->Multiply(other, MultiplicationAlgorithm::kAuto);
+}
+
+template<typename T>
+Polynomial<T>& Polynomial<T>::operator*=(const T& other) {
+    for (auto& coef : this->coefficients) {
+        coef *= other;
+    }
+    this->Normalize();
+    return *this;
+}
+
+// Expression templates. +, - and multiplication by a constant return lazy
+// nodes instead of polynomials, so a chain like a + b + c - d is evaluated
+// in a single pass into a single buffer once it is assigned to a
+// Polynomial. Nodes refer to lvalue polynomial operands, so an expression
+// must not outlive them; an rvalue polynomial operand is instead reused as
+// the result buffer and the operation is done eagerly in place. Products of
+// two polynomials stay eager.
+template<typename T>
+class PolynomialLeaf {
+private:
+    const Polynomial<T>& poly;
+
+public:
+    using ValueType = T;
+
+    explicit PolynomialLeaf(const Polynomial<T>& poly): poly(poly) {}
+
+    size_t Size() const {
+        return poly.Degree() + 1;
+    }
+
+    const T& Coefficient(size_t i) const {
+        return poly[static_cast<int>(i)];
+    }
+};
+
+template<typename T>
+class ConstantTerm {
+private:
+    T value;
+
+public:
+    using ValueType = T;
+
+    explicit ConstantTerm(const T& value): value(value) {}
+
+    size_t Size() const {
+        return 1;
+    }
+
+    T Coefficient(size_t i) const {
+        return i ? T{} : value;
+    }
+};
+
+template<typename L, typename R, bool Subtract>
+class PolynomialSumExpr {
+private:
+    L left;
+    R right;
+
+public:
+    using ValueType = typename L::ValueType;
+
+    PolynomialSumExpr(const L& left, const R& right): left(left), right(right) {}
+
+    size_t Size() const {
+        return std::max(left.Size(), right.Size());
+    }
+
+    ValueType Coefficient(size_t i) const {
+        if constexpr (Subtract) {
+            return left.Coefficient(i) - right.Coefficient(i);
+        } else {
+            return left.Coefficient(i) + right.Coefficient(i);
+        }
+    }
+};
+
+template<typename E>
+class PolynomialScaleExpr {
+private:
+    E expr;
+    typename E::ValueType factor;
+
+public:
+    using ValueType = typename E::ValueType;
+
+    PolynomialScaleExpr(const E& expr, const ValueType& factor): expr(expr), factor(factor) {}
+
+    size_t Size() const {
+        return expr.Size();
+    }
+
+    ValueType Coefficient(size_t i) const {
+        return expr.Coefficient(i) * factor;
+    }
+};
+
+template<typename L, typename R, bool Subtract>
+struct IsPolynomialExpr<PolynomialSumExpr<L, R, Subtract>> : std::true_type {};
+
+template<typename E>
+struct IsPolynomialExpr<PolynomialScaleExpr<E>> : std::true_type {};
+
+// Coefficient type of a Polynomial or expression X, void for anything else.
+template<typename X, typename = void>
+struct PolynomialValue {
+    using type = void;
+};
+
+template<typename T>
+struct PolynomialValue<Polynomial<T>> {
+    using type = T;
+};
+
+template<typename E>
+struct PolynomialValue<E, std::enable_if_t<IsPolynomialExpr<E>::value>> {
+    using type = typename E::ValueType;
+};
+
+// T for an operation on two polynomials or expressions over T, or on one of
+// them and a T; void if A and B are not such a pair.
+template<typename A, typename B, typename DA = std::decay_t<A>, typename DB = std::decay_t<B>,
+         typename VA = typename PolynomialValue<DA>::type, typename VB = typename PolynomialValue<DB>::type>
+using PolynomialOperandsValue = std::conditional_t<
+    !std::is_void_v<VA> && (std::is_same_v<VA, VB> || std::is_same_v<DB, VA>), VA,
+    std::conditional_t<!std::is_void_v<VB> && std::is_same_v<DA, VB>, VB, void>>;
+
+template<typename T, typename X>
+auto MakeExprNode(const X& x) {
+    if constexpr (std::is_same_v<X, Polynomial<T>>) {
+        return PolynomialLeaf<T>(x);
+    } else if constexpr (std::is_same_v<X, T>) {
+        return ConstantTerm<T>(x);
+    } else {
+        return x;
+    }
+}
+
+template<typename T, bool Subtract, typename A, typename B>
+auto CombineLinear(A&& a, B&& b) {
+    // A or B deduced as a plain Polynomial<T> means an rvalue polynomial.
+    if constexpr (std::is_same_v<A, Polynomial<T>>) {
+        Polynomial<T> result(std::move(a));
+        result = PolynomialSumExpr<PolynomialLeaf<T>, decltype(MakeExprNode<T>(b)), Subtract>(
+            PolynomialLeaf<T>(result), MakeExprNode<T>(b));
+        return result;
+    } else if constexpr (std::is_same_v<B, Polynomial<T>>) {
+        Polynomial<T> result(std::move(b));
+        result = PolynomialSumExpr<decltype(MakeExprNode<T>(a)), PolynomialLeaf<T>, Subtract>(
+            MakeExprNode<T>(a), PolynomialLeaf<T>(result));
+        return result;
+    } else {
+        return PolynomialSumExpr<decltype(MakeExprNode<T>(a)), decltype(MakeExprNode<T>(b)), Subtract>(
+            MakeExprNode<T>(a), MakeExprNode<T>(b));
+    }
+}
+
+template<typename T, typename X>
+auto Scale(X&& x, const T& factor) {
+    if constexpr (std::is_same_v<X, Polynomial<T>>) {
+        Polynomial<T> result(std::move(x));
+        result *= factor;
+        return result;
+    } else {
+        return PolynomialScaleExpr<decltype(MakeExprNode<T>(x))>(MakeExprNode<T>(x), factor);
+    }
+}
+
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T>>>
+auto operator+(A&& poly1, B&& poly2) {
+    return CombineLinear<T, false>(std::forward<A>(poly1), std::forward<B>(poly2));
+}
+
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T>>>
+auto operator-(A&& poly1, B&& poly2) {
+    return CombineLinear<T, true>(std::forward<A>(poly1), std::forward<B>(poly2));
+}
+
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T>>>
+auto operator*(A&& poly1, B&& poly2) {
+    if constexpr (std::is_same_v<std::decay_t<B>, T>) {
+        return Scale<T>(std::forward<A>(poly1), poly2);
+    } else if constexpr (std::is_same_v<std::decay_t<A>, T>) {
+        return Scale<T>(std::forward<B>(poly2), poly1);
+    } else {
+        Polynomial<T> tmp(std::forward<A>(poly1));
+        tmp *= poly2;
+        return tmp;
+    }
+}
+
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T>>>
+Polynomial<T> operator/(A&& poly1, B&& poly2) {
+    Polynomial<T> tmp(std::forward<A>(poly1));
+    tmp /= poly2;
+    return tmp;
+}
+
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T>>>
+Polynomial<T> operator%(A&& poly1, B&& poly2) {
+    Polynomial<T> tmp(std::forward<A>(poly1));
+    tmp %= poly2;
+    return tmp;
+}
+
+// 2x2 polynomial matrix acting on remainder pairs (a, b).
+template<typename T>
+struct PolynomialMatrix {
+    Polynomial<T> a00 = Polynomial<T>(T(1)), a01, a10, a11 = Polynomial<T>(T(1));
+
+    std::pair<Polynomial<T>, Polynomial<T>> Apply(const Polynomial<T>& a, const Polynomial<T>& b) const {
+        return {a00 * a + a01 * b, a10 * a + a11 * b};
+    }
+
+    PolynomialMatrix<T> operator*(const PolynomialMatrix<T>& other) const {
+        return {a00 * other.a00 + a01 * other.a10, a00 * other.a01 + a01 * other.a11,
+                a10 * other.a00 + a11 * other.a10, a10 * other.a01 + a11 * other.a11};
+    }
+
+    // One Euclid step (c, d) -> (d, c mod d), recorded as [[0, 1], [1, -q]] * this.
+    void EuclidStep(Polynomial<T>& c, Polynomial<T>& d) {
+        auto [quotient, remainder] = c.DivMod(d);
+        c = std::move(d);
+        d = std::move(remainder);
+        Polynomial<T> b00 = a10, b01 = a11;
+        a10 = a00 - quotient * a10;
+        a11 = a01 - quotient * a11;
+        a00 = std::move(b00);
+        a01 = std::move(b01);
+    }
+};
+
+// Below kHalfGcdThreshold the half-GCD recursion hands over to Euclid steps
+// on the matrix; Gcd only starts the recursion from kGcdEuclidThreshold, as
+// plain Euclid stays faster up to about that degree (measured in main()).
+constexpr int kHalfGcdThreshold = 512;
+constexpr int kGcdEuclidThreshold = 4096;
+
+template<typename T>
+Polynomial<T> DivideByPowerOfX(const Polynomial<T>& poly, int k) {
+    if (k > poly.Degree()) return Polynomial<T>();
+    return Polynomial<T>(poly.begin() + k, poly.end());
+}
+
+// For deg a > deg b: the matrix taking (a, b) to the consecutive Euclidean
+// remainders (c, d) with deg c >= ceil(deg a / 2) > deg d. The quotients of
+// the top halves of a and b agree with those of a and b for as long as the
+// remainders stay above the cut, so half the work recurses on half the
+// degree (Knuth, Schönhage).
+template<typename T>
+PolynomialMatrix<T> HalfGcd(const Polynomial<T>& a, const Polynomial<T>& b) {
+    const int n = a.Degree(), m = (n + 1) / 2;
+    PolynomialMatrix<T> matrix;
+    if (b.Degree() < m) {
+        return matrix;
+    }
+    Polynomial<T> c, d;
+    if (n < kHalfGcdThreshold) {
+        c = a;
+        d = b;
+        while (d.Degree() >= m) matrix.EuclidStep(c, d);
+        return matrix;
+    }
+    matrix = HalfGcd(DivideByPowerOfX(a, m), DivideByPowerOfX(b, m));
+    std::tie(c, d) = matrix.Apply(a, b);
+    if (d.Degree() < m) {
+        return matrix;
+    }
+    matrix.EuclidStep(c, d);
+    if (d.Degree() < m) {
+        return matrix;
+    }
+    const int k = 2 * m - c.Degree();
+    return HalfGcd(DivideByPowerOfX(c, k), DivideByPowerOfX(d, k)) * matrix;
+}
+
+// Monic greatest common divisor over a field (Modular or floating-point T;
+// in floating point only meaningful for exactly representable inputs).
+template<typename T>
+Polynomial<T> Gcd(Polynomial<T> a, Polynomial<T> b) {
+    static_assert(!std::is_integral_v<T>, "Gcd needs field coefficients");
+    if (a.Degree() < b.Degree()) std::swap(a, b);
+    while (b.Degree() >= 0) {
+        if (a.Degree() > b.Degree() && b.Degree() >= kGcdEuclidThreshold) {
+            std::tie(a, b) = HalfGcd(a, b).Apply(a, b);
+            if (b.Degree() < 0) break;
+        }
+        Polynomial<T> remainder = a % b;
+        a = std::move(b);
+        b = std::move(remainder);
+    }
+    if (a.Degree() >= 0) {
+        a *= T(1) / a[a.Degree()];
+    }
+    return a;
+}
+
+// Comparisons and output involving an expression; two plain polynomials
+// use the friends above.
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T> && (IsPolynomialExpr<A>::value || IsPolynomialExpr<B>::value)>>
+bool operator ==(const A& poly1, const B& poly2) {
+    auto left = MakeExprNode<T>(poly1);
+    auto right = MakeExprNode<T>(poly2);
+    for (size_t i = 0; i < std::max(left.Size(), right.Size()); i++) {
+        if (!(left.Coefficient(i) == right.Coefficient(i))) return false;
+    }
+    return true;
+}
+
+template<typename A, typename B, typename T = PolynomialOperandsValue<A, B>,
+         typename = std::enable_if_t<!std::is_void_v<T> && (IsPolynomialExpr<A>::value || IsPolynomialExpr<B>::value)>>
+bool operator !=(const A& poly1, const B& poly2) {
+    return !(poly1 == poly2);
+}
+
+template<typename T>
+typename std::vector<T>::const_iterator Polynomial<T>::begin() const  {
+    return this->cbegin();
+}
+
+template<typename T>
+typename std::vector<T>::reverse_iterator Polynomial<T>::rbegin() {
+    return this->coefficients.rbegin();
+}
+
+template<typename T>
+typename std::vector<T>::const_iterator Polynomial<T>::end() const {
+    return this->cend();
+}
+
+template<typename T>
+typename std::vector<T>::reverse_iterator Polynomial<T>::rend() {
+    return this->coefficients.rend();
+}
+
+template<typename T>
+typename std::vector<T>::const_iterator Polynomial<T>::cbegin() const {
+    return this->coefficients.cbegin();
+}
+
+template<typename T>
+typename std::vector<T>::const_reverse_iterator Polynomial<T>::crbegin() const {
+    return this->coefficients.crbegin();
+}
+
+template<typename T>
+typename std::vector<T>::const_iterator Polynomial<T>::cend() const {
+    return this->coefficients.cend();
+}
+
+template<typename T>
+typename std::vector<T>::const_reverse_iterator Polynomial<T>::crend() const {
+    return this->coefficients.crend();
+}
+
+template<typename T>
+std::ostream& operator <<(std::ostream& out, const Polynomial<T>& poly) {
+    for (auto it = poly.crbegin(); it != poly.crend(); it++) {
+        out << *it;
+        if (it != std::prev(poly.crend())) out << ' ';
+    }
+    return out;
+} 
+
+template<typename E, typename = std::enable_if_t<IsPolynomialExpr<E>::value>>
+std::ostream& operator <<(std::ostream& out, const E& expr) {
+    return out << Polynomial<typename E::ValueType>(expr);
+}
+
+// Sparse counterpart of Polynomial: nonzero terms as (exponent, coefficient)
+// pairs sorted by exponent, so x^10000000 + 1 takes two terms. Products use
+// a heap merge of the term lists unless there are so many term pairs that
+// the dense (Karatsuba/NTT) product is cheaper.
+template<typename T>
+class SparsePolynomial {
+public:
+    using Term = std::pair<size_t, T>;
+
+    // A polynomial with at least one term per kDensityThreshold exponents is
+    // cheaper dense: a term costs the size of several dense coefficients.
+    static constexpr size_t kDensityThreshold = 8;
+    // The heap merge pays per pair of terms, a dense product per result
+    // coefficient; measured in main(), a pair costs about as much as
+    // kPairsPerDenseCoefficient coefficients.
+    static constexpr size_t kPairsPerDenseCoefficient = 2;
+
+private:
+    std::vector<Term> terms;
+    static const T zero;
+
+    void Normalize();  // sort, sum equal exponents, drop zero coefficients
+    static T Power(T base, size_t power);
+    static std::vector<Term> Merge(const std::vector<Term>& a, const std::vector<Term>& b, bool subtract);
+
+public:
+    SparsePolynomial() = default;
+    SparsePolynomial(const T&);
+    SparsePolynomial(std::vector<Term> terms);  // any order, equal exponents are summed
+    explicit SparsePolynomial(const Polynomial<T>& dense);
+
+    Polynomial<T> ToDense() const;
+    bool PrefersDense() const;
+    static bool PrefersSparse(const Polynomial<T>& dense);
+
+    int64_t Degree() const;
+    size_t TermCount() const;
+
+    const T& operator [](size_t i) const;
+    T operator()(const T& value) const;
+
+    SparsePolynomial<T>& operator +=(const SparsePolynomial<T>& other);
+    SparsePolynomial<T>& operator +=(const T& other);
+    SparsePolynomial<T>& operator -=(const SparsePolynomial<T>& other);
+    SparsePolynomial<T>& operator -=(const T& other);
+    SparsePolynomial<T>& operator *=(const SparsePolynomial<T>& other);
+    SparsePolynomial<T>& operator *=(const T& other);
+
+    typename std::vector<Term>::const_iterator begin() const;
+    typename std::vector<Term>::const_iterator end() const;
+};
+
+template<typename T>
+const T SparsePolynomial<T>::zero = T{};
+
+template<typename T>
+void SparsePolynomial<T>::Normalize() {
+    std::sort(this->terms.begin(), this->terms.end(),
+              [](const Term& a, const Term& b) { return a.first < b.first; });
+    size_t size = 0;
+    for (size_t i = 0; i < this->terms.size(); i++) {
+        if (size && this->terms[size - 1].first == this->terms[i].first) {
+            this->terms[size - 1].second += this->terms[i].second;
+        } else {
+            if (size && this->terms[size - 1].second == T{}) size--;
+            this->terms[size++] = std::move(this->terms[i]);
+        }
+    }
+    if (size && this->terms[size - 1].second == T{}) size--;
+    this->terms.resize(size);
+}
+
+template<typename T>
+SparsePolynomial<T>::SparsePolynomial(const T& coef) {
+    if (coef != T{}) this->terms.emplace_back(0, coef);
+}
+
+template<typename T>
+SparsePolynomial<T>::SparsePolynomial(std::vector<Term> terms):
+    terms(std::move(terms))
 {
     this->Normalize();
-};
+}
 
 template<typename T>
-template<typename Iter>
-Polynomial<T>::Polynomial(Iter first, Iter second) {
-    while(first != second) {
-        coefficients.push_back(*first++);
+SparsePolynomial<T>::SparsePolynomial(const Polynomial<T>& dense) {
+    size_t exponent = 0;
+    for (const auto& coef : dense) {
+        if (coef != T{}) this->terms.emplace_back(exponent, coef);
+        exponent++;
     }
-    this->Normalize();
 }
 
 template<typename T>
-Polynomial<T>::Polynomial(const Polynomial<T>& other):
-    coefficients(other.coefficients)
-{
-    this->Normalize();
-};
+Polynomial<T> SparsePolynomial<T>::ToDense() const {
+    std::vector<T> coefficients(this->Degree() + 1);
+    for (const auto& [exponent, coef] : this->terms) {
+        coefficients[exponent] = coef;
+    }
+    return Polynomial<T>(std::move(coefficients));
+}
 
 template<typename T>
-Polynomial<T>::Polynomial(Polynomial<T>&& other):
-    coefficients(std::move(other.coefficients))
-{
-    this->Normalize();
-    other.coefficients.clear();  
-};
+bool SparsePolynomial<T>::PrefersDense() const {
+    return this->terms.size() * kDensityThreshold >= static_cast<size_t>(this->Degree() + 1);
+}
 
 template<typename T>
-void Polynomial<T>::operator=(const Polynomial<T>& other) {
-    this->coefficients = other.coefficients;
+bool SparsePolynomial<T>::PrefersSparse(const Polynomial<T>& dense) {
+    size_t nonzero = std::count_if(dense.begin(), dense.end(), [](const T& coef) { return coef != T{}; });
+    return nonzero * kDensityThreshold < static_cast<size_t>(dense.Degree() + 1);
 }
 
 template<typename T>
-void Polynomial<T>::operator=(Polynomial<T>&& other) {
-    this->coefficients = std::move(other.coefficients);
-    other.coefficients.clear();
+int64_t SparsePolynomial<T>::Degree() const {
+    return this->terms.empty() ? -1 : static_cast<int64_t>(this->terms.back().first);
 }
 
 template<typename T>
-int Polynomial<T>::Degree() const {
-    return static_cast<int>(coefficients.size()) - 1;
+size_t SparsePolynomial<T>::TermCount() const {
+    return this->terms.size();
 }
 
 template<typename T>
-bool operator ==(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
-    return poly1.coefficients == poly2.coefficients;
+bool operator ==(const SparsePolynomial<T>& poly1, const SparsePolynomial<T>& poly2) {
+    return poly1.TermCount() == poly2.TermCount() && std::equal(poly1.begin(), poly1.end(), poly2.begin());
 }
 
 template<typename T>
-bool operator ==(const Polynomial<T>& poly1, const T& poly2) {
+bool operator ==(const SparsePolynomial<T>& poly1, const T& poly2) {
     if (poly1.Degree() == -1 && poly2 == T{}) return true;
     return (poly1.Degree() == 0 && poly1[0] == poly2);
 }
 
 template<typename T>
-bool operator ==(const T& poly1, const Polynomial<T>& poly2) {
-    if (poly2.Degree() == -1 && poly1 == T{}) return true;
-    return (poly2.Degree() == 0 && poly2[0] == poly1);
+bool operator ==(const T& poly1, const SparsePolynomial<T>& poly2) {
+    return poly2 == poly1;
 }
 
 template<typename T>
-bool operator !=(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
+bool operator !=(const SparsePolynomial<T>& poly1, const SparsePolynomial<T>& poly2) {
     return !(poly1 == poly2);
 }
 
 template<typename T>
-bool operator !=(const Polynomial<T>& poly1, const T& poly2) {
+bool operator !=(const SparsePolynomial<T>& poly1, const T& poly2) {
     return !(poly1 == poly2);
 }
 
 template<typename T>
-bool operator !=(const T& poly1, const Polynomial<T>& poly2) {
+bool operator !=(const T& poly1, const SparsePolynomial<T>& poly2) {
     return !(poly1 == poly2);
 }
 
 template<typename T>
-const T& Polynomial<T>::operator[](int i) const {
-    if (i < 0 || i > this->Degree()) {
-        return Polynomial<T>::zero;
+const T& SparsePolynomial<T>::operator[](size_t i) const {
+    auto it = std::lower_bound(this->terms.begin(), this->terms.end(), i,
+                               [](const Term& term, size_t exponent) { return term.first < exponent; });
+    if (it == this->terms.end() || it->first != i) {
+        return SparsePolynomial<T>::zero;
     }
-    return coefficients[i];
+    return it->second;
 }
 
 template<typename T>
-T Polynomial<T>::operator()(const T& value) const {
-    if (this->Degree() == -1) return T{};
-    T result = this->coefficients[0], base = value;
-    for (auto it = std::next(this->coefficients.begin()); it != this->coefficients.end(); it++) {
-        result += *it * base;
-        base *= value;
+T SparsePolynomial<T>::Power(T base, size_t power) {
+    T result = T(1);
+    for (; power; power >>= 1) {
+        if (power & 1) result *= base;
+        base *= base;
     }
     return result;
 }
 
 template<typename T>
-Polynomial<T>& Polynomial<T>::operator+=(const Polynomial<T>& other) {
-    this->coefficients.resize(std::max(this->Degree() + 1, other.Degree() + 1));
-    for (int i = 0; i <= other.Degree(); i++) {
-        this->coefficients[i] += other.coefficients[i];
+T SparsePolynomial<T>::operator()(const T& value) const {
+    // Horner over the terms, jumping each exponent gap by squaring.
+    T result{};
+    size_t previous = 0;
+    for (auto it = this->terms.rbegin(); it != this->terms.rend(); it++) {
+        if (it != this->terms.rbegin()) result *= Power(value, previous - it->first);
+        result += it->second;
+        previous = it->first;
     }
-    this->Normalize();
-    return *this;
+    return result * Power(value, previous);
 }
 
 template<typename T>
-Polynomial<T>& Polynomial<T>::operator+=(const T& other) {
-    this->coefficients.resize(std::max(this->Degree() + 1, 1));
-    this->coefficients[0] += other;
-    this->Normalize();
-    return *this;
+std::vector<typename SparsePolynomial<T>::Term> SparsePolynomial<T>::Merge(
+        const std::vector<Term>& a, const std::vector<Term>& b, bool subtract) {
+    std::vector<Term> result;
+    result.reserve(a.size() + b.size());
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (j == b.size() || (i < a.size() && a[i].first < b[j].first)) {
+            result.push_back(a[i++]);
+        } else if (i == a.size() || b[j].first < a[i].first) {
+            result.emplace_back(b[j].first, subtract ? T{} - b[j].second : b[j].second);
+            j++;
+        } else {
+            T coef = a[i].second;
+            if (subtract) coef -= b[j].second; else coef += b[j].second;
+            if (coef != T{}) result.emplace_back(a[i].first, std::move(coef));
+            i++;
+            j++;
+        }
+    }
+    return result;
 }
 
 template<typename T>
-Polynomial<T>& Polynomial<T>::operator-=(const Polynomial<T>& other) {
-    this->coefficients.resize(std::max(this->Degree() + 1, other.Degree() + 1));
-    for (int i = 0; i <= other.Degree(); i++) {
-        this->coefficients[i] -= other.coefficients[i];
-    }
-    this->Normalize();
+SparsePolynomial<T>& SparsePolynomial<T>::operator+=(const SparsePolynomial<T>& other) {
+    this->terms = Merge(this->terms, other.terms, false);
     return *this;
 }
 
 template<typename T>
-Polynomial<T>& Polynomial<T>::operator-=(const T& other) {
-    this->coefficients.resize(std::max(this->Degree() + 1, 1));
-    this->coefficients[0] -= other;
-    this->Normalize();
+SparsePolynomial<T>& SparsePolynomial<T>::operator+=(const T& other) {
+    return *this += SparsePolynomial<T>(other);
+}
+
+template<typename T>
+SparsePolynomial<T>& SparsePolynomial<T>::operator-=(const SparsePolynomial<T>& other) {
+    this->terms = Merge(this->terms, other.terms, true);
     return *this;
 }
 
 template<typename T>
-Polynomial<T>& Polynomial<T>::operator*=(const Polynomial<T>& other) {
-    if (this->Degree() == -1 || other.Degree() == -1) {
-        this->coefficients.resize(0);
+SparsePolynomial<T>& SparsePolynomial<T>::operator-=(const T& other) {
+    return *this -= SparsePolynomial<T>(other);
+}
+
+template<typename T>
+SparsePolynomial<T>& SparsePolynomial<T>::operator*=(const SparsePolynomial<T>& other) {
+    if (this->terms.empty() || other.terms.empty()) {
+        this->terms.clear();
         return *this;
     }
-    std::vector<T> tmp(this->Degree() + other.Degree() + 1);
-    for (int i = 0; i <= other.Degree(); i++) {
-        for (int j = 0; j <= this->Degree(); j++) {
-            tmp[i + j] += this->coefficients[j] * other.coefficients[i];
+    const size_t result_length = static_cast<size_t>(this->Degree() + other.Degree() + 1);
+    if (this->terms.size() * other.terms.size() >= kPairsPerDenseCoefficient * result_length) {
+        *this = SparsePolynomial<T>(this->ToDense() * other.ToDense());
+        return *this;
+    }
+    // Johnson's heap merge: one cursor per term of the shorter factor walks
+    // the longer one, so the products come out in exponent order and only
+    // min(n, m) of them are pending at a time.
+    const std::vector<Term>& a = this->terms.size() <= other.terms.size() ? this->terms : other.terms;
+    const std::vector<Term>& b = this->terms.size() <= other.terms.size() ? other.terms : this->terms;
+    using Cursor = std::pair<size_t, size_t>;  // (exponent, index into a); index into b in next[]
+    std::vector<size_t> next(a.size(), 0);
+    std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> heap;
+    for (size_t i = 0; i < a.size(); i++) {
+        heap.emplace(a[i].first + b[0].first, i);
+    }
+    std::vector<Term> result;
+    while (!heap.empty()) {
+        auto [exponent, i] = heap.top();
+        heap.pop();
+        T product = a[i].second * b[next[i]].second;
+        if (!result.empty() && result.back().first == exponent) {
+            result.back().second += product;
+        } else {
+            if (!result.empty() && result.back().second == T{}) result.pop_back();
+            result.emplace_back(exponent, std::move(product));
+        }
+        if (++next[i] < b.size()) {
+            heap.emplace(a[i].first + b[next[i]].first, i);
         }
     }
-    this->coefficients = std::move(tmp);
-    this->Normalize();
+    if (!result.empty() && result.back().second == T{}) result.pop_back();
+    this->terms = std::move(result);
     return *this;
 }
 
 template<typename T>
-Polynomial<T>& Polynomial<T>::operator*=(const T& other) {
-    for (auto& coef : this->coefficients) {
-        coef *= other;
+SparsePolynomial<T>& SparsePolynomial<T>::operator*=(const T& other) {
+    for (auto& term : this->terms) {
+        term.second *= other;
     }
-    this->Normalize();
+    this->terms.erase(std::remove_if(this->terms.begin(), this->terms.end(),
+                                     [](const Term& term) { return term.second == T{}; }),
+                      this->terms.end());
     return *this;
 }
 
 template<typename T>
-Polynomial<T> operator+(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
+SparsePolynomial<T> operator+(const SparsePolynomial<T>& poly1, const SparsePolynomial<T>& poly2) {
     auto tmp(poly1);
     tmp += poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator+(const Polynomial<T>& poly1, const T& poly2) {
+SparsePolynomial<T> operator+(const SparsePolynomial<T>& poly1, const T& poly2) {
     auto tmp(poly1);
     tmp += poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator+(const T& poly1, const Polynomial<T>& poly2) {
+SparsePolynomial<T> operator+(const T& poly1, const SparsePolynomial<T>& poly2) {
     auto tmp(poly2);
     tmp += poly1;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator-(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
+SparsePolynomial<T> operator-(const SparsePolynomial<T>& poly1, const SparsePolynomial<T>& poly2) {
     auto tmp(poly1);
     tmp -= poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator-(const Polynomial<T>& poly1, const T& poly2) {
+SparsePolynomial<T> operator-(const SparsePolynomial<T>& poly1, const T& poly2) {
     auto tmp(poly1);
     tmp -= poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator-(const T& poly1, const Polynomial<T>& poly2) {
-    auto tmp(poly2);
-    tmp -= poly1;
+SparsePolynomial<T> operator-(const T& poly1, const SparsePolynomial<T>& poly2) {
+    SparsePolynomial<T> tmp(poly1);
+    tmp -= poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator*(const Polynomial<T>& poly1, const Polynomial<T>& poly2) {
+SparsePolynomial<T> operator*(const SparsePolynomial<T>& poly1, const SparsePolynomial<T>& poly2) {
     auto tmp(poly1);
     tmp *= poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator*(const Polynomial<T>& poly1, const T& poly2) {
+SparsePolynomial<T> operator*(const SparsePolynomial<T>& poly1, const T& poly2) {
     auto tmp(poly1);
     tmp *= poly2;
     return tmp;
 }
 
 template<typename T>
-Polynomial<T> operator*(const T& poly1, const Polynomial<T>& poly2) {
+SparsePolynomial<T> operator*(const T& poly1, const SparsePolynomial<T>& poly2) {
     auto tmp(poly2);
     tmp *= poly1;
     return tmp;
 }
 
 template<typename T>
-typename std::vector<T>::const_iterator Polynomial<T>::begin() const  {
-    return this->cbegin();
+typename std::vector<typename SparsePolynomial<T>::Term>::const_iterator SparsePolynomial<T>::begin() const {
+    return this->terms.cbegin();
 }
 
 template<typename T>
-typename std::vector<T>::reverse_iterator Polynomial<T>::rbegin() {
-    return this->coefficients.rbegin();
+typename std::vector<typename SparsePolynomial<T>::Term>::const_iterator SparsePolynomial<T>::end() const {
+    return this->terms.cend();
 }
 
+// Same text as the dense form: every coefficient from the highest degree
+// down, zeros included.
 template<typename T>
-typename std::vector<T>::const_iterator Polynomial<T>::end() const {
-    return this->cend();
+std::ostream& operator <<(std::ostream& out, const SparsePolynomial<T>& poly) {
+    auto it = poly.end();
+    for (int64_t exponent = poly.Degree(); exponent >= 0; exponent--) {
+        if (it != poly.begin() && std::prev(it)->first == static_cast<size_t>(exponent)) {
+            --it;
+            out << it->second;
+        } else {
+            out << T{};
+        }
+        if (exponent) out << ' ';
+    }
+    return out;
 }
 
-template<typename T>
-typename std::vector<T>::reverse_iterator Polynomial<T>::rend() {
-    return this->coefficients.rend();
+// Fixed-size counterpart of Polynomial for small polynomials known at compile
+// time, such as approximation kernels: N coefficients, lowest degree first, in
+// a std::array, so nothing is allocated and everything works in constexpr.
+// The size is part of the type (trailing zeros are kept): a sum has max(N, M)
+// coefficients, a product N + M - 1.
+template<typename T, size_t N>
+class StaticPolynomial {
+    static_assert(N > 0, "StaticPolynomial needs at least one coefficient");
+
+private:
+    std::array<T, N> coefficients{};
+
+    // Coefficients [Begin, Begin + Count) at x; powers[k] = x^(2^k).
+    // Estrin's scheme: the halves are independent, so the dependency chain
+    // is log2(N) multiply-adds long instead of Horner's N.
+    template<size_t Begin, size_t Count>
+    constexpr T EstrinRange(const T* powers) const;
+
+public:
+    static constexpr size_t kSize = N;
+
+    constexpr StaticPolynomial() = default;
+    constexpr StaticPolynomial(const T&);
+    constexpr StaticPolynomial(const std::array<T, N>& coefficients);
+    explicit StaticPolynomial(const Polynomial<T>& dense);  // std::length_error if it does not fit
+
+    Polynomial<T> ToDense() const;
+
+    constexpr int Degree() const;
+
+    constexpr const T& operator [](size_t i) const;
+    constexpr T operator()(const T& value) const;
+
+    template<size_t M>
+    constexpr StaticPolynomial<T, N>& operator +=(const StaticPolynomial<T, M>& other);
+    constexpr StaticPolynomial<T, N>& operator +=(const T& other);
+    template<size_t M>
+    constexpr StaticPolynomial<T, N>& operator -=(const StaticPolynomial<T, M>& other);
+    constexpr StaticPolynomial<T, N>& operator -=(const T& other);
+    constexpr StaticPolynomial<T, N>& operator *=(const T& other);
+
+    constexpr typename std::array<T, N>::const_iterator begin() const;
+    constexpr typename std::array<T, N>::const_iterator end() const;
+};
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N>::StaticPolynomial(const T& coef) {
+    this->coefficients[0] = coef;
 }
 
-template<typename T>
-typename std::vector<T>::const_iterator Polynomial<T>::cbegin() const {
-    return this->coefficients.cbegin();
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N>::StaticPolynomial(const std::array<T, N>& coefficients):
+    coefficients(coefficients)
+{}
+
+template<typename T, size_t N>
+StaticPolynomial<T, N>::StaticPolynomial(const Polynomial<T>& dense) {
+    if (dense.Degree() >= static_cast<int>(N)) {
+        throw std::length_error("Polynomial does not fit into StaticPolynomial!");
+    }
+    std::copy(dense.begin(), dense.end(), this->coefficients.begin());
 }
 
-template<typename T>
-typename std::vector<T>::const_reverse_iterator Polynomial<T>::crbegin() const {
-    return this->coefficients.crbegin();
+template<typename T, size_t N>
+Polynomial<T> StaticPolynomial<T, N>::ToDense() const {
+    return Polynomial<T>(this->coefficients.begin(), this->coefficients.end());
 }
 
-template<typename T>
-typename std::vector<T>::const_iterator Polynomial<T>::cend() const {
+template<typename T, size_t N>
+constexpr int StaticPolynomial<T, N>::Degree() const {
+    for (size_t i = N; i-- > 0;) {
+        if (this->coefficients[i] != T{}) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+template<typename T, size_t N>
+constexpr const T& StaticPolynomial<T, N>::operator [](size_t i) const {
+    return this->coefficients[i];
+}
+
+template<typename T, size_t N>
+template<size_t Begin, size_t Count>
+constexpr T StaticPolynomial<T, N>::EstrinRange(const T* powers) const {
+    if constexpr (Count == 1) {
+        return this->coefficients[Begin];
+    } else {
+        // The low part takes the largest power of two below Count.
+        constexpr size_t level = [] {
+            size_t k = 0;
+            while ((size_t{2} << k) < Count) k++;
+            return k;
+        }();
+        constexpr size_t half = size_t{1} << level;
+        return this->EstrinRange<Begin, half>(powers) +
+               powers[level] * this->EstrinRange<Begin + half, Count - half>(powers);
+    }
+}
+
+template<typename T, size_t N>
+constexpr T StaticPolynomial<T, N>::operator()(const T& value) const {
+    constexpr size_t levels = [] {
+        size_t k = 1;
+        while ((size_t{1} << k) < N) k++;
+        return k;
+    }();
+    std::array<T, levels> powers{};
+    powers[0] = value;
+    for (size_t k = 1; k < levels; k++) {
+        powers[k] = powers[k - 1] * powers[k - 1];
+    }
+    return this->EstrinRange<0, N>(powers.data());
+}
+
+template<typename T, size_t N>
+template<size_t M>
+constexpr StaticPolynomial<T, N>& StaticPolynomial<T, N>::operator +=(const StaticPolynomial<T, M>& other) {
+    static_assert(M <= N, "The sum does not fit; use operator+");
+    for (size_t i = 0; i < M; i++) {
+        this->coefficients[i] += other[i];
+    }
+    return *this;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N>& StaticPolynomial<T, N>::operator +=(const T& other) {
+    this->coefficients[0] += other;
+    return *this;
+}
+
+template<typename T, size_t N>
+template<size_t M>
+constexpr StaticPolynomial<T, N>& StaticPolynomial<T, N>::operator -=(const StaticPolynomial<T, M>& other) {
+    static_assert(M <= N, "The difference does not fit; use operator-");
+    for (size_t i = 0; i < M; i++) {
+        this->coefficients[i] -= other[i];
+    }
+    return *this;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N>& StaticPolynomial<T, N>::operator -=(const T& other) {
+    this->coefficients[0] -= other;
+    return *this;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N>& StaticPolynomial<T, N>::operator *=(const T& other) {
+    for (auto& coef : this->coefficients) {
+        coef *= other;
+    }
+    return *this;
+}
+
+template<typename T, size_t N>
+constexpr typename std::array<T, N>::const_iterator StaticPolynomial<T, N>::begin() const {
+    return this->coefficients.cbegin();
+}
+
+template<typename T, size_t N>
+constexpr typename std::array<T, N>::const_iterator StaticPolynomial<T, N>::end() const {
     return this->coefficients.cend();
 }
 
-template<typename T>
-typename std::vector<T>::const_reverse_iterator Polynomial<T>::crend() const {
-    return this->coefficients.crend();
+template<typename T, size_t N, size_t M>
+constexpr bool operator ==(const StaticPolynomial<T, N>& poly1, const StaticPolynomial<T, M>& poly2) {
+    for (size_t i = 0; i < std::max(N, M); i++) {
+        T coef1 = i < N ? poly1[i] : T{};
+        T coef2 = i < M ? poly2[i] : T{};
+        if (coef1 != coef2) return false;
+    }
+    return true;
 }
 
-template<typename T>
-std::ostream& operator <<(std::ostream& out, const Polynomial<T>& poly) {
-    for (auto it = poly.crbegin(); it != poly.crend(); it++) {
-        out << *it;
-        if (it != std::prev(poly.crend())) out << ' ';
+template<typename T, size_t N, size_t M>
+constexpr bool operator !=(const StaticPolynomial<T, N>& poly1, const StaticPolynomial<T, M>& poly2) {
+    return !(poly1 == poly2);
+}
+
+template<typename T, size_t N, size_t M>
+constexpr StaticPolynomial<T, std::max(N, M)> operator+(const StaticPolynomial<T, N>& poly1, const StaticPolynomial<T, M>& poly2) {
+    StaticPolynomial<T, std::max(N, M)> result;
+    result += poly1;
+    result += poly2;
+    return result;
+}
+
+template<typename T, size_t N, size_t M>
+constexpr StaticPolynomial<T, std::max(N, M)> operator-(const StaticPolynomial<T, N>& poly1, const StaticPolynomial<T, M>& poly2) {
+    StaticPolynomial<T, std::max(N, M)> result;
+    result += poly1;
+    result -= poly2;
+    return result;
+}
+
+template<typename T, size_t N, size_t M>
+constexpr StaticPolynomial<T, N + M - 1> operator*(const StaticPolynomial<T, N>& poly1, const StaticPolynomial<T, M>& poly2) {
+    std::array<T, N + M - 1> product{};
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < M; j++) {
+            product[i + j] += poly1[i] * poly2[j];
+        }
+    }
+    return StaticPolynomial<T, N + M - 1>(product);
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N> operator+(StaticPolynomial<T, N> poly1, const T& poly2) {
+    return poly1 += poly2;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N> operator+(const T& poly1, StaticPolynomial<T, N> poly2) {
+    return poly2 += poly1;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N> operator-(StaticPolynomial<T, N> poly1, const T& poly2) {
+    return poly1 -= poly2;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N> operator-(const T& poly1, const StaticPolynomial<T, N>& poly2) {
+    return StaticPolynomial<T, N>(poly1) - poly2;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N> operator*(StaticPolynomial<T, N> poly1, const T& poly2) {
+    return poly1 *= poly2;
+}
+
+template<typename T, size_t N>
+constexpr StaticPolynomial<T, N> operator*(const T& poly1, StaticPolynomial<T, N> poly2) {
+    return poly2 *= poly1;
+}
+
+// Same text as the dense form, trailing zeros dropped.
+template<typename T, size_t N>
+std::ostream& operator <<(std::ostream& out, const StaticPolynomial<T, N>& poly) {
+    for (int i = poly.Degree(); i >= 0; i--) {
+        out << poly[i];
+        if (i) out << ' ';
     }
     return out;
-} 
+}
 
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <random>
 #include <sstream>
+#include <tuple>
 
 // --- ВСТАВЬ СЮДА СВОЙ КЛАСС Polynomial<T> ---
 
+// Счётчик выделений памяти для тестов шаблонов выражений
+static size_t allocation_count = 0;
+
+// noinline: once these are inlined into a container's allocate and deallocate,
+// GCC 12 reports the malloc/free pair behind them as -Wmismatched-new-delete,
+// a false positive.
+[[gnu::noinline]] void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
 // Вспомогательная функция: проверка вывода
 std::string toString(const Polynomial<int>& p) {
     std::ostringstream oss;
@@ -470,6 +2163,682 @@ int main() {
     assert(p1 != p3);
     std::cout << "✅ Сравнение многочленов работает\n";
 
+    // 14. Быстрое умножение точно для целых T: все алгоритмы совпадают с
+    //     умножением «в столбик» на любых размерах, включая пороги
+    std::mt19937_64 rng(2024);
+    auto random_poly = [&rng](size_t size, int64_t bound) {
+        std::uniform_int_distribution<int64_t> dist(-bound, bound);
+        std::vector<int64_t> c(size);
+        for (auto& x : c) x = dist(rng);
+        c.back() = bound;
+        return Polynomial<int64_t>(c);
+    };
+    const MultiplicationAlgorithm algorithms[] = {
+        MultiplicationAlgorithm::kAuto, MultiplicationAlgorithm::kKaratsuba, MultiplicationAlgorithm::kTransform};
+    const size_t sizes[] = {1, 2, 63, 64, 65, 100, 511, 1023, 1024, 3001};
+    // Границы коэффициентов выбраны так, чтобы CRT шёл по 1, 2 и 3 простым
+    for (int64_t bound : {int64_t{3}, int64_t{1000000}, int64_t{30000000}}) {
+        for (size_t n : sizes) {
+            for (size_t m : {size_t{1}, size_t{65}, size_t{1024}, n}) {
+                auto a = random_poly(n, bound), b = random_poly(m, bound);
+                auto expected = a;
+                expected.Multiply(b, MultiplicationAlgorithm::kSchoolbook);
+                assert(expected.Degree() == static_cast<int>(n + m - 2));
+                for (auto algorithm : algorithms) {
+                    auto product = a;
+                    product.Multiply(b, algorithm);
+                    assert(product == expected);
+                }
+            }
+        }
+    }
+    assert(random_poly(700, 5) * Polynomial<int64_t>() == Polynomial<int64_t>());
+    std::cout << "✅ Karatsuba и NTT совпадают со столбиком для int64_t на размерах до 3001 (CRT по 1, 2 и 3 простым)\n";
+
+    // 15. Беззнаковые T: результат — ровно то же переполнение по модулю 2^w;
+    //     при слишком больших коэффициентах NTT уступает место Карацубе
+    {
+        std::vector<uint32_t> ca(2000), cb(1500);
+        for (auto& x : ca) x = static_cast<uint32_t>(rng());
+        for (auto& x : cb) x = static_cast<uint32_t>(rng());
+        Polynomial<uint32_t> a(ca), b(cb);
+        auto expected = a;
+        expected.Multiply(b, MultiplicationAlgorithm::kSchoolbook);
+        auto product = a;
+        product.Multiply(b, MultiplicationAlgorithm::kTransform);
+        assert(product == expected && a * b == expected);
+
+        std::vector<uint64_t> wa(1000), wb(1000);
+        for (auto& x : wa) x = rng();
+        for (auto& x : wb) x = rng();
+        Polynomial<uint64_t> big_a(wa), big_b(wb);
+        auto big_expected = big_a;
+        big_expected.Multiply(big_b, MultiplicationAlgorithm::kSchoolbook);
+        auto big_product = big_a;
+        big_product.Multiply(big_b, MultiplicationAlgorithm::kTransform);
+        assert(big_product == big_expected && big_a * big_b == big_expected);
+    }
+    std::cout << "✅ uint32_t через NTT и uint64_t через запасную Карацубу дают тот же вычет по модулю 2^w\n";
+
+    // 16. Модулярные коэффициенты: NTT-простое и произвольное простое
+    {
+        using Fp = Modular<998244353>;
+        using Fq = Modular<1000000007>;
+        assert(Fq(-1).Value() == 1000000006 && Fq(3) * Fq(3).Inverse() == Fq(1));
+        std::vector<Fp> pa(3000), pb(2500);
+        std::vector<Fq> qa(3000), qb(2500);
+        for (size_t i = 0; i < pa.size(); i++) pa[i] = Fp(static_cast<int64_t>(rng() >> 1)), qa[i] = Fq(static_cast<int64_t>(rng() >> 1));
+        for (size_t i = 0; i < pb.size(); i++) pb[i] = Fp(static_cast<int64_t>(rng() >> 1)), qb[i] = Fq(static_cast<int64_t>(rng() >> 1));
+        Polynomial<Fp> a(pa), b(pb);
+        Polynomial<Fq> c(qa), d(qb);
+        auto expected_ab = a;
+        auto expected_cd = c;
+        expected_ab.Multiply(b, MultiplicationAlgorithm::kSchoolbook);
+        expected_cd.Multiply(d, MultiplicationAlgorithm::kSchoolbook);
+        assert(a * b == expected_ab && c * d == expected_cd);
+        auto karatsuba = c;
+        karatsuba.Multiply(d, MultiplicationAlgorithm::kKaratsuba);
+        assert(karatsuba == expected_cd);
+    }
+    std::cout << "✅ Modular<998244353> и Modular<1000000007>: NTT и Карацуба совпадают со столбиком\n";
+
+    // 17. Плавающая точка: FFT укладывается в оценку ошибки округления
+    {
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        for (size_t n : {size_t{100}, size_t{1000}, size_t{20000}}) {
+            std::vector<double> ca(n), cb(n);
+            for (auto& x : ca) x = dist(rng);
+            for (auto& x : cb) x = dist(rng);
+            Polynomial<double> a(ca), b(cb);
+            auto expected = a;
+            expected.Multiply(b, MultiplicationAlgorithm::kSchoolbook);
+            auto product = a;
+            product.Multiply(b, MultiplicationAlgorithm::kTransform);
+            const double bound = 1e-16 * std::log2(2.0 * n) * n * 8;
+            double max_error = 0;
+            for (int i = 0; i <= expected.Degree(); i++) {
+                max_error = std::max(max_error, std::fabs(product[i] - expected[i]));
+            }
+            assert(product.Degree() == expected.Degree() && max_error < bound);
+            std::cout << "   n = " << n << ": max ошибка FFT " << max_error << " (граница " << bound << ")\n";
+        }
+    }
+    std::cout << "✅ FFT для double в пределах eps·log(n)·n\n";
+
+    // 18. Точки перехода: время умножения двух многочленов длины n
+    std::cout << "\n⏱  Умножение многочленов длины n (мкс): столбик / Карацуба / NTT|FFT\n";
+    auto time_us = [](auto&& fn) {
+        int reps = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::micro> dur{};
+        do {
+            fn();
+            ++reps;
+            dur = std::chrono::steady_clock::now() - start;
+        } while (dur.count() < 20000);
+        return dur.count() / reps;
+    };
+    auto bench = [&](const char* name, auto make) {
+        std::cout << "   " << name << ":\n";
+        for (size_t n = 8; n <= 8192; n *= 2) {
+            auto a = make(n), b = make(n);
+            std::cout << "     n = " << n;
+            for (auto algorithm : {MultiplicationAlgorithm::kSchoolbook, MultiplicationAlgorithm::kKaratsuba,
+                                   MultiplicationAlgorithm::kTransform}) {
+                std::cout << "  " << time_us([&] {
+                    auto product = a;
+                    product.Multiply(b, algorithm);
+                    assert(product.Degree() == static_cast<int>(2 * n - 2));
+                });
+            }
+            std::cout << '\n';
+        }
+    };
+    bench("int64_t", [&](size_t n) { return random_poly(n, 1000); });
+    bench("double", [&](size_t n) {
+        std::vector<double> c(n, 1.5);
+        for (auto& x : c) x += static_cast<double>(rng() % 1000);
+        return Polynomial<double>(c);
+    });
+    {
+        auto a = random_poly(100001, 1000), b = random_poly(100001, 1000);
+        auto start = std::chrono::steady_clock::now();
+        auto product = a * b;
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        assert(product.Degree() == 200000 && product[200000] == 1000000);
+        std::cout << "   степень 10^5 × 10^5 (int64_t, авто): " << dur.count() << " с\n";
+    }
+
+    // 19. Разреженный многочлен: x^10000000 + 1 хранится двумя членами
+    {
+        using Sparse = SparsePolynomial<int64_t>;
+        Sparse huge({{10000000, 1}, {0, 1}});
+        assert(huge.TermCount() == 2 && huge.Degree() == 10000000);
+        assert(huge[10000000] == 1 && huge[0] == 1 && huge[5] == 0 && huge[20000000] == 0);
+        assert(huge(1) == 2 && huge(-1) == 2 && huge(0) == 1);
+        Sparse square = huge * huge;  // x^20000000 + 2x^10000000 + 1
+        assert(square == Sparse({{20000000, 1}, {10000000, 2}, {0, 1}}));
+        assert(square - huge * huge == int64_t{0} && (square - square).Degree() == -1);
+        Sparse x_plus_1({{1, 1}, {0, 1}}), x_minus_1({{1, 1}, {0, -1}});
+        assert(x_plus_1 * x_minus_1 == Sparse({{2, 1}, {0, -1}}));
+        assert((x_plus_1 * x_minus_1).TermCount() == 2);
+        assert(Sparse({{3, 2}, {3, -2}}) == int64_t{0} && Sparse(7) == int64_t{7} && int64_t{7} != Sparse(8));
+        assert(huge * int64_t{0} == int64_t{0} && (huge + int64_t{-1}) == Sparse(std::vector<Sparse::Term>{{10000000, 1}}));
+        assert(int64_t{1} - huge == Sparse(std::vector<Sparse::Term>{{10000000, -1}}));
+        std::cout << "✅ x^10000000 + 1: " << huge.TermCount() << " члена, (x^10^7 + 1)^2 = "
+                  << square.TermCount() << " члена\n";
+    }
+
+    // 20. Разреженная арифметика совпадает с плотной на любых плотностях
+    for (int per_mille : {5, 50, 300, 1000}) {
+        auto random_sparse = [&](size_t degree) {
+            std::vector<int64_t> c(degree + 1);
+            for (auto& x : c) {
+                if (static_cast<int>(rng() % 1000) < per_mille) x = static_cast<int64_t>(rng() % 21) - 10;
+            }
+            c.back() = 3;
+            return Polynomial<int64_t>(c);
+        };
+        for (int iter = 0; iter < 10; iter++) {
+            auto a = random_sparse(rng() % 2000), b = random_sparse(rng() % 300);
+            SparsePolynomial<int64_t> sa(a), sb(b);
+            assert(sa.ToDense() == a && sa.Degree() == a.Degree());
+            assert(SparsePolynomial<int64_t>::PrefersSparse(a) == !sa.PrefersDense());
+            assert((sa + sb).ToDense() == a + b);
+            assert((sa - sb).ToDense() == a - b);
+            assert((sb - sa).ToDense() == b - a);
+            assert((sa * sb).ToDense() == a * b);
+            assert((sa * int64_t{-3}).ToDense() == a * int64_t{-3});
+            assert((sa + int64_t{5}).ToDense() == a + int64_t{5});
+            assert(sa(1) == a(1) && sa(-1) == a(-1));
+            assert(sa[7] == a[7] && sa == SparsePolynomial<int64_t>(a));
+            std::ostringstream dense_text, sparse_text;
+            dense_text << a;
+            sparse_text << sa;
+            assert(dense_text.str() == sparse_text.str());
+        }
+    }
+    std::cout << "✅ +, -, *, (), [], << разреженного = плотного при заполненности от 0.5% до 100%\n";
+
+    // 21. Память и умножение: разреженное против плотного
+    std::cout << "\n⏱  Разреженные многочлены:\n";
+    {
+        SparsePolynomial<int64_t> huge({{10000000, 1}, {0, 1}});
+        std::cout << "   x^10^7 + 1: плотно " << (huge.Degree() + 1) * sizeof(int64_t) / (1 << 20)
+                  << " МБ, разреженно " << huge.TermCount() * sizeof(SparsePolynomial<int64_t>::Term) << " байт\n";
+        // Heap merge costs the same for any exponent spacing, so spreading
+        // the exponents 4096 times apart times it at the same term count.
+        const size_t degree = 4095;
+        for (size_t count : {32, 64, 96, 128, 192, 256, 1024}) {
+            std::vector<SparsePolynomial<int64_t>::Term> dense_terms, spread_terms;
+            for (size_t k = 0; k < count; k++) {
+                size_t exponent = k * degree / (count - 1);
+                int64_t coef = static_cast<int64_t>(rng() % 1000) + 1;
+                dense_terms.emplace_back(exponent, coef);
+                spread_terms.emplace_back(exponent * 4096, coef);
+            }
+            SparsePolynomial<int64_t> a(dense_terms), spread(spread_terms);
+            Polynomial<int64_t> dense = a.ToDense();
+            // Произведения уходят в sink, который печатается: иначе при NDEBUG
+            // замерялись бы пустые лямбды
+            int64_t sink = 0;
+            double heap_us = time_us([&] { sink += static_cast<int64_t>((spread * spread).TermCount()); });
+            double dense_us = time_us([&] { sink += (dense * dense).Degree(); });
+            double auto_us = time_us([&] { sink += (a * a).Degree(); });
+            assert((dense * dense).Degree() == 2 * static_cast<int>(degree));
+            assert((a * a).Degree() == 2 * static_cast<int64_t>(degree));
+            std::cout << "   степень " << degree << ", членов " << count << ": куча " << heap_us
+                      << " мкс, плотное " << dense_us << " мкс, авто " << auto_us << " мкс (sink " << (sink != 0) << ")\n";
+        }
+    }
+
+    // 22. Evaluate по массиву точек совпадает с operator() поточечно
+    {
+        std::vector<int64_t> ci(50);
+        for (auto& x : ci) x = static_cast<int64_t>(rng() % 7) - 3;
+        Polynomial<int64_t> pi(ci);
+        std::vector<int64_t> xi = {0, 1, -1, 2, -2};
+        std::vector<int64_t> yi(xi.size());
+        pi.Evaluate(xi.data(), xi.size(), yi.data());
+        for (size_t i = 0; i < xi.size(); i++) assert(yi[i] == pi(xi[i]));
+        Polynomial<int64_t>().Evaluate(xi.data(), xi.size(), yi.data());
+        assert(std::count(yi.begin(), yi.end(), 0) == static_cast<long>(yi.size()));
+
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        for (size_t degree : {size_t{0}, size_t{3}, size_t{2000}}) {
+            std::vector<double> cd(degree + 1);
+            for (auto& x : cd) x = dist(rng);
+            Polynomial<double> pd(cd);
+            Polynomial<float> pf(std::vector<float>(cd.begin(), cd.end()));
+            for (size_t count : {size_t{0}, size_t{1}, size_t{7}, size_t{8}, size_t{1001}}) {
+                std::vector<double> xd(count), yd(count);
+                for (auto& x : xd) x = dist(rng);
+                std::vector<float> xf(xd.begin(), xd.end()), yf(count);
+                pd.Evaluate(xd.data(), count, yd.data());
+                pf.Evaluate(xf.data(), count, yf.data());
+                for (size_t i = 0; i < count; i++) {
+                    assert(std::fabs(yd[i] - pd(xd[i])) < 1e-12);
+                    assert(std::fabs(yf[i] - pf(xf[i])) < 1e-4f);
+                }
+            }
+        }
+
+        using Fp = Modular<998244353>;
+        for (size_t degree : {size_t{300}, size_t{512}, size_t{2047}}) {
+            std::vector<Fp> cp(degree + 1);
+            for (auto& x : cp) x = Fp(static_cast<int64_t>(rng() >> 1));
+            Polynomial<Fp> pp(cp);
+            for (size_t count : {size_t{300}, size_t{2048}, size_t{5000}}) {
+                std::vector<Fp> xp(count), yp(count);
+                for (auto& x : xp) x = Fp(static_cast<int64_t>(rng() >> 1));
+                xp[0] = xp[1];  // repeated points are fine
+                pp.Evaluate(xp.data(), count, yp.data());
+                for (size_t i = 0; i < count; i++) assert(yp[i] == pp(xp[i]));
+            }
+        }
+    }
+    std::cout << "✅ Evaluate: int64_t, double/float (SIMD Horner) и Modular (дерево произведений) = operator()\n";
+
+    // 23. Многочлен степени 2000 в пакете точек
+    std::cout << "\n⏱  Вычисление многочлена степени 2000 (нс на точку):\n";
+    {
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        std::vector<double> cd(2001);
+        for (auto& x : cd) x = dist(rng);
+        Polynomial<double> pd(cd);
+        Polynomial<float> pf(std::vector<float>(cd.begin(), cd.end()));
+        const size_t count = 1 << 16;
+        std::vector<double> xd(count), yd(count), power_sum(count);
+        for (auto& x : xd) x = dist(rng);
+        std::vector<float> xf(xd.begin(), xd.end()), yf(count);
+        double old_ns = time_us([&] {
+            // The former loop: a second loop-carried multiply for x^k.
+            for (size_t i = 0; i < count; i++) {
+                double result = cd[0], base = xd[i];
+                for (size_t k = 1; k < cd.size(); k++) {
+                    result += cd[k] * base;
+                    base *= xd[i];
+                }
+                power_sum[i] = result;
+            }
+        }) * 1000 / count;
+        double point_ns = time_us([&] { for (size_t i = 0; i < count; i++) yd[i] = pd(xd[i]); }) * 1000 / count;
+        double batch_ns = time_us([&] { pd.Evaluate(xd.data(), count, yd.data()); }) * 1000 / count;
+        double batch_float_ns = time_us([&] { pf.Evaluate(xf.data(), count, yf.data()); }) * 1000 / count;
+        for (size_t i = 0; i < count; i++) assert(std::fabs(power_sum[i] - yd[i]) < 1e-9);
+        std::cout << "   double: степени по точке " << old_ns << ", Horner по точке " << point_ns
+                  << ", Evaluate " << batch_ns << ", float Evaluate " << batch_float_ns << '\n';
+
+        using Fp = Modular<998244353>;
+        std::vector<Fp> xp(count), yp(count);
+        for (auto& x : xp) x = Fp(static_cast<int64_t>(rng() >> 1));
+        for (size_t degree : {256, 512, 2000}) {
+            std::vector<Fp> cp(degree + 1);
+            for (auto& x : cp) x = Fp(static_cast<int64_t>(rng() >> 1));
+            Polynomial<Fp> pp(cp);
+            double horner_ns = time_us([&] { for (size_t i = 0; i < count; i++) yp[i] = pp(xp[i]); }) * 1000 / count;
+            double tree_ns = time_us([&] { pp.Evaluate(xp.data(), count, yp.data()); }) * 1000 / count;
+            std::cout << "   Modular<998244353>, степень " << degree << ": Horner по точке " << horner_ns
+                      << ", Evaluate " << tree_ns << '\n';
+        }
+    }
+
+    // 24. Шаблоны выражений: цепочка +, - и умножений на число — один проход
+    //     и одно выделение памяти; rvalue-операнды отдают свой буфер
+    {
+        Polynomial<int64_t> a(std::vector<int64_t>{1, 2, 3, 4}), b(std::vector<int64_t>{5, 6}),
+            c(std::vector<int64_t>{0, 0, 0, 0, 0, 7}), d(std::vector<int64_t>{1, 1, 1, 1});
+        const std::vector<int64_t> expected = {5, 7, 2, 3, 0, 7};
+
+        [[maybe_unused]] size_t before = allocation_count;
+        Polynomial<int64_t> r = a + b + c - d;
+        assert(allocation_count - before == 1);
+        assert(std::vector<int64_t>(r.begin(), r.end()) == expected);
+
+        before = allocation_count;
+        r = a + b + c - d;  // буфер r уже достаточного размера
+        r = r + a - a;      // выражение ссылается на сам r
+        assert(allocation_count - before == 0);
+        assert(std::vector<int64_t>(r.begin(), r.end()) == expected);
+
+        before = allocation_count;
+        Polynomial<int64_t> s = int64_t{2} * a - b * int64_t{3} + int64_t{5} - (c - d) * int64_t{-1};
+        assert(allocation_count - before == 1);
+        assert(s == Polynomial<int64_t>(std::vector<int64_t>{-9, -15, 5, 7, 0, 7}));
+
+        Polynomial<int64_t> owner = a + c;  // вместимость 6
+        before = allocation_count;
+        Polynomial<int64_t> t = std::move(owner) + b - d + a * int64_t{2};
+        t = std::move(t) - c;
+        assert(allocation_count - before == 0);
+        assert(t == int64_t{3} * a + b - d);
+
+        // Сокращение старших степеней нормализует результат; T - P считается верно
+        assert(Polynomial<int64_t>(a - a).Degree() == -1 && a - a == Polynomial<int64_t>());
+        assert(Polynomial<int64_t>((a + c) - c).Degree() == 3);
+        assert(int64_t{10} - b == Polynomial<int64_t>(std::vector<int64_t>{5, -6}));
+        assert(int64_t{10} - Polynomial<int64_t>(b) == Polynomial<int64_t>(std::vector<int64_t>{5, -6}));
+        assert(a + b != a && a + int64_t{1} == Polynomial<int64_t>(std::vector<int64_t>{2, 2, 3, 4}));
+        assert((a + b) * (c - d) == Polynomial<int64_t>(a + b) * Polynomial<int64_t>(c - d));
+        std::ostringstream text;
+        text << a - d;
+        assert(text.str() == "3 2 1 0");
+    }
+    std::cout << "✅ a + b + c - d: одно выделение памяти, присваивание в готовый буфер — ни одного\n";
+
+    // 25. Длинная сумма: 16 слагаемых по 200000 коэффициентов
+    std::cout << "\n⏱  Сумма 16 многочленов длины 200000:\n";
+    {
+        std::vector<Polynomial<int64_t>> terms;
+        for (int k = 0; k < 16; k++) terms.push_back(random_poly(200000, 1000));
+        const auto& t = terms;
+        Polynomial<int64_t> fused, pairwise;
+        size_t fused_allocations = allocation_count;
+        double fused_us = time_us([&] {
+            fused = t[0] + t[1] + t[2] + t[3] + t[4] + t[5] + t[6] + t[7] +
+                    t[8] + t[9] + t[10] + t[11] + t[12] + t[13] + t[14] + t[15];
+        });
+        fused_allocations = allocation_count - fused_allocations;
+        size_t pairwise_allocations = allocation_count;
+        double pairwise_us = time_us([&] {
+            // Как раньше: каждый operator+ копировал левый операнд
+            Polynomial<int64_t> sum = terms[0];
+            for (int k = 1; k < 16; k++) {
+                Polynomial<int64_t> tmp(sum);
+                tmp += terms[k];
+                sum = std::move(tmp);
+            }
+            pairwise = std::move(sum);
+        });
+        pairwise_allocations = allocation_count - pairwise_allocations;
+        assert(fused == pairwise);
+        std::cout << "   выражение: " << fused_us << " мкс, попарно с временными: " << pairwise_us
+                  << " мкс (выделений за все прогоны: " << fused_allocations << " против "
+                  << pairwise_allocations << ")\n";
+    }
+
+    // 26. Деление с остатком, Reducer и НОД
+    {
+        auto check_div_mod = [](const auto& a, const auto& b) {
+            auto [q, r] = a.DivMod(b);
+            assert(r.Degree() < b.Degree());
+            assert(q * b + r == a);
+            assert(a / b == q && a % b == r);
+        };
+        // Целые: делитель со старшим коэффициентом ±1 — деление точное
+        for (int m : {1, 5, 40, 1100}) {
+            auto b = random_poly(m + 1, 100);
+            std::vector<int64_t> cb(b.begin(), b.end());
+            cb.back() = m % 2 ? 1 : -1;
+            // Частное случайного делимого растёт экспоненциально, поэтому
+            // делимое собирается из известных частного и остатка
+            Polynomial<int64_t> divisor(cb), q0 = random_poly(m + 1200, 100), r0 = random_poly(m, 100);
+            check_div_mod(q0 * divisor + r0, divisor);
+            assert((q0 * divisor + r0).DivMod(divisor) == std::make_pair(q0, r0));
+            check_div_mod(r0, divisor);
+        }
+        [[maybe_unused]] bool thrown = false;
+        try {
+            random_poly(10, 5).DivMod(Polynomial<int64_t>(std::vector<int64_t>{1, 2}));
+        } catch (const std::domain_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        thrown = false;
+        try {
+            random_poly(10, 5) % Polynomial<int64_t>();
+        } catch (const std::domain_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        Polynomial<int64_t> x2_minus_1(std::vector<int64_t>{-1, 0, 1}), x_minus_1(std::vector<int64_t>{-1, 1});
+        assert(x2_minus_1 / x_minus_1 == Polynomial<int64_t>(std::vector<int64_t>{1, 1}));
+        assert(x2_minus_1 % x_minus_1 == Polynomial<int64_t>());
+        Polynomial<int64_t> tmp_div = x2_minus_1;
+        tmp_div /= x_minus_1 + int64_t{2};
+        assert(tmp_div == Polynomial<int64_t>(std::vector<int64_t>{-1, 1}));
+
+        // Поле вычетов: любой ненулевой старший коэффициент, оба алгоритма
+        using Fp = Modular<998244353>;
+        auto random_fp = [&rng](int degree) {
+            std::vector<Fp> c(degree + 1);
+            for (auto& x : c) x = Fp(static_cast<int64_t>(rng() >> 2));
+            c.back() = Fp(static_cast<int64_t>(rng() % 1000) + 1);
+            return Polynomial<Fp>(c);
+        };
+        for (auto [n, m] : {std::pair{10, 3}, std::pair{2000, 1000}, std::pair{5000, 1500}, std::pair{4000, 3900}}) {
+            check_div_mod(random_fp(n), random_fp(m));
+        }
+        // Принудительный выбор алгоритма даёт тот же результат по обе стороны порогов
+        for (auto [n, m] : {std::pair{1, 1}, std::pair{40, 7}, std::pair{700, 300}, std::pair{2500, 1100}}) {
+            auto a = random_fp(n), b = random_fp(m);
+            assert(a.DivMod(b, DivisionAlgorithm::kLong) == a.DivMod(b, DivisionAlgorithm::kNewton));
+        }
+        assert(x2_minus_1.DivMod(x_minus_1, DivisionAlgorithm::kNewton) == x2_minus_1.DivMod(x_minus_1));
+
+        // Плавающая точка: у x^m + c(x) с Σ|c_i| < 1 все корни внутри единичного
+        // круга, поэтому ряд Ньютона для частного хорошо обусловлен
+        {
+            std::uniform_real_distribution<double> dist(-1.0, 1.0);
+            auto random_double = [&](int degree, double scale) {
+                std::vector<double> c(degree + 1);
+                for (auto& x : c) x = dist(rng) * scale;
+                c.back() = 1.0;
+                return Polynomial<double>(c);
+            };
+            for (int m : {20, 1200}) {
+                auto b = random_double(m, 0.5 / m), q0 = random_double(m + 100, 1.0), r0 = random_double(m - 1, 1.0);
+                auto [q, r] = (q0 * b + r0).DivMod(b);
+                for (int i = 0; i <= m + 100; i++) assert(std::fabs(q[i] - q0[i]) < 1e-9);
+                for (int i = 0; i < m; i++) assert(std::fabs(r[i] - r0[i]) < 1e-9);
+            }
+        }
+
+        // Reducer совпадает с % на любых степенях делимого
+        for (int m : {1, 2, 3, 511, 512, 1000}) {
+            auto divisor = random_fp(m);
+            Polynomial<Fp>::Reducer reducer(divisor), long_reducer(divisor, DivisionAlgorithm::kLong),
+                newton_reducer(divisor, DivisionAlgorithm::kNewton);
+            for (int n : {0, m - 1, m, 2 * m - 2, 5 * m + 7}) {
+                auto a = random_fp(std::max(n, 0));
+                assert(reducer.Reduce(a) == a % divisor);
+                assert(long_reducer.Reduce(a) == a % divisor && newton_reducer.Reduce(a) == a % divisor);
+            }
+        }
+        Polynomial<int64_t>::Reducer int_reducer(x2_minus_1 * (x2_minus_1 + int64_t{2}));
+        auto int_dividend = random_poly(50, 100);
+        assert(int_reducer.Reduce(int_dividend) == int_dividend % int_reducer.Divisor());
+
+        // НОД через half-GCD: общий множитель g находится точно
+        for (auto [dg, du, dv] : {std::tuple{3, 5, 4}, std::tuple{100, 300, 250}, std::tuple{700, 1500, 1200}, std::tuple{1000, 4000, 3500}}) {
+            auto g = random_fp(dg);
+            g *= Fp(1) / g[dg];  // унитарный
+            auto u = random_fp(du), v = random_fp(dv);
+            assert(Gcd(g * u, g * v) == g);
+            assert(Gcd(g * v, g * u) == g);
+        }
+        auto lone = random_fp(50);
+        assert(Gcd(lone, Polynomial<Fp>()) == lone * (Fp(1) / lone[50]));
+        assert(Gcd(Polynomial<Fp>(), Polynomial<Fp>()) == Polynomial<Fp>());
+        assert(Gcd(random_fp(3000), random_fp(2999)) == Fp(1));
+        Polynomial<double> x_minus_2(std::vector<double>{-2, 1}), x_minus_3(std::vector<double>{-3, 1}),
+            x_minus_1d(std::vector<double>{-1, 1});
+        assert(Gcd(x_minus_1d * x_minus_2, x_minus_1d * x_minus_3) == x_minus_1d);
+    }
+    std::cout << "✅ DivMod, /, %, Reducer и Gcd: q·b + r = a для int64_t, Modular и double, НОД через half-GCD\n";
+
+    // 27. Деление и НОД: O(n²) против Ньютона и half-GCD
+    {
+        using Fp = Modular<998244353>;
+        auto random_fp = [&rng](int degree) {
+            std::vector<Fp> c(degree + 1);
+            for (auto& x : c) x = Fp(static_cast<int64_t>(rng() >> 2));
+            c.back() = Fp(1);
+            return Polynomial<Fp>(c);
+        };
+        // Оба способа делят одни и те же многочлены: делимое степени m + q - 1
+        // на делитель степени m даёт частное из q коэффициентов.
+        const int divisor_degrees[] = {128, 256, 512, 1024, 4096};
+        const int quotient_sizes[] = {32, 128, 512, 1024, 4096};
+        std::cout << "\n⏱  DivMod, делитель степени m, частное из q коэффициентов (Modular<998244353>, мкс, столбик / Ньютон):\n";
+        std::cout << "   m \\ q";
+        for (int q : quotient_sizes) std::cout << std::setw(18) << q;
+        std::cout << '\n';
+        for (int m : divisor_degrees) {
+            std::cout << "   " << std::setw(5) << m;
+            for (int q : quotient_sizes) {
+                auto a = random_fp(m + q - 1), b = random_fp(m);
+                std::pair<Polynomial<Fp>, Polynomial<Fp>> long_result, newton_result;
+                double long_us = time_us([&] { long_result = a.DivMod(b, DivisionAlgorithm::kLong); });
+                double newton_us = time_us([&] { newton_result = a.DivMod(b, DivisionAlgorithm::kNewton); });
+                assert(long_result == newton_result);
+                std::ostringstream cell;
+                cell << std::fixed << std::setprecision(0) << long_us << " / " << newton_us;
+                std::cout << std::setw(18) << cell.str();
+            }
+            std::cout << '\n';
+        }
+
+        // Reducer работает с произведениями двух остатков: степень 2m - 2, частное из m - 1 коэффициентов.
+        std::cout << "   Reducer, делимое степени 2m - 2 (мкс): столбик / Ньютон с готовым обращением\n";
+        for (int m : divisor_degrees) {
+            auto a = random_fp(2 * m - 2), b = random_fp(m);
+            Polynomial<Fp>::Reducer long_reducer(b, DivisionAlgorithm::kLong), newton_reducer(b, DivisionAlgorithm::kNewton);
+            Polynomial<Fp> r1, r2;
+            double long_us = time_us([&] { r1 = long_reducer.Reduce(a); });
+            double newton_us = time_us([&] { r2 = newton_reducer.Reduce(a); });
+            assert(r1 == r2 && r1 == a % b);
+            std::cout << "     m = " << m << ": " << long_us << " / " << newton_us << '\n';
+        }
+
+        std::cout << "   НОД многочленов степени n (мс): Евклид / half-GCD\n";
+        for (int n : {2000, 8000, 16000}) {
+            auto a = random_fp(n), b = random_fp(n - 1);
+            Polynomial<Fp> euclid, fast;
+            double euclid_ms = time_us([&] {
+                Polynomial<Fp> x = a, y = b;
+                while (y.Degree() >= 0) {
+                    Polynomial<Fp> r = x % y;
+                    x = std::move(y);
+                    y = std::move(r);
+                }
+                euclid = x * (Fp(1) / x[x.Degree()]);
+            }) / 1000;
+            double fast_ms = time_us([&] { fast = Gcd(a, b); }) / 1000;
+            assert(euclid == fast);
+            std::cout << "     n = " << n << ": " << euclid_ms << " / " << fast_ms << '\n';
+        }
+    }
+
+    // 28. StaticPolynomial: вычисления на этапе компиляции и размеры результатов
+    {
+        constexpr StaticPolynomial<int64_t, 4> sp(std::array<int64_t, 4>{1, 2, 3, 4});  // 4x^3 + 3x^2 + 2x + 1
+        constexpr StaticPolynomial<int64_t, 2> sq(std::array<int64_t, 2>{-1, 1});       // x - 1
+        static_assert(sp(2) == 1 + 2 * 2 + 3 * 4 + 4 * 8);
+        static_assert(sp(0) == 1 && sq(1) == 0 && sp.Degree() == 3);
+        constexpr auto sum = sp + sq;
+        constexpr auto product = sp * sq;
+        static_assert(std::is_same_v<decltype(sum), const StaticPolynomial<int64_t, 4>>);
+        static_assert(std::is_same_v<decltype(product), const StaticPolynomial<int64_t, 5>>);
+        static_assert(std::is_same_v<decltype(sq - sp), StaticPolynomial<int64_t, 4>>);
+        static_assert(sum == StaticPolynomial<int64_t, 4>(std::array<int64_t, 4>{0, 3, 3, 4}));
+        static_assert(product == StaticPolynomial<int64_t, 5>(std::array<int64_t, 5>{-1, -1, -1, -1, 4}));
+        static_assert(sp - sp == StaticPolynomial<int64_t, 1>() && (sp - sp).Degree() == -1);
+        static_assert(int64_t{2} * sq + int64_t{2} == StaticPolynomial<int64_t, 2>(std::array<int64_t, 2>{0, 2}));
+        static_assert(int64_t{1} - sq == StaticPolynomial<int64_t, 2>(std::array<int64_t, 2>{2, -1}));
+        static_assert(product(3) == sp(3) * sq(3));
+
+        using Fp = Modular<998244353>;
+        constexpr StaticPolynomial<Fp, 3> fp(std::array<Fp, 3>{Fp(5), Fp(-1), Fp(7)});
+        static_assert((fp * fp)(Fp(123456)) == fp(Fp(123456)) * fp(Fp(123456)));
+
+        // Совпадение с Polynomial на всех размерах разбиения Эстрина
+        auto check_static = [&](auto size) {
+            constexpr size_t N = decltype(size)::value;
+            auto dense = random_poly(N, 20), other = random_poly(3, 20);
+            StaticPolynomial<int64_t, N> s(dense);
+            StaticPolynomial<int64_t, 3> t(other);
+            assert(s.ToDense() == dense && s.Degree() == dense.Degree());
+            for (int64_t x = -4; x <= 4; x++) assert(s(x) == dense(x));
+            assert((s + t).ToDense() == dense + other);
+            assert((s - t).ToDense() == dense - other);
+            assert((t - s).ToDense() == other - dense);
+            assert((s * t).ToDense() == dense * other);
+            assert((s * int64_t{-3}).ToDense() == dense * int64_t{-3});
+            std::ostringstream out1, out2;
+            out1 << s;
+            out2 << dense;
+            assert(out1.str() == out2.str());
+            std::uniform_real_distribution<double> dist(-1.0, 1.0);
+            std::array<double, N> c{};
+            for (auto& x : c) x = dist(rng);
+            StaticPolynomial<double, N> sd(c);
+            Polynomial<double> dd = sd.ToDense();
+            for ([[maybe_unused]] double x : {-1.5, -0.3, 0.0, 0.7, 2.0}) assert(std::fabs(sd(x) - dd(x)) < 1e-12 * (1 + std::fabs(dd(x))));
+        };
+        auto check_sizes = [&](auto... sizes) { (check_static(sizes), ...); };
+        check_sizes(std::integral_constant<size_t, 1>{}, std::integral_constant<size_t, 2>{},
+                    std::integral_constant<size_t, 3>{}, std::integral_constant<size_t, 5>{},
+                    std::integral_constant<size_t, 8>{}, std::integral_constant<size_t, 9>{},
+                    std::integral_constant<size_t, 13>{});
+
+        // Меньшие многочлены помещаются, большие — нет
+        assert((StaticPolynomial<int64_t, 6>(sq.ToDense()) == sq));
+        [[maybe_unused]] bool thrown = false;
+        try {
+            StaticPolynomial<int64_t, 3> too_small(sp.ToDense());
+        } catch (const std::length_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    std::cout << "✅ StaticPolynomial: constexpr-вычисления, размеры суммы и произведения, совпадение с Polynomial\n";
+
+    // 29. Вычисление ядра фиксированной степени: Polynomial против StaticPolynomial
+    std::cout << "\n⏱  Многочлен Тейлора для exp степени 11 на 10^6 точек (нс на точку):\n";
+    {
+        constexpr auto taylor_exp = [] {
+            std::array<double, 12> c{};
+            double factorial = 1;
+            for (size_t i = 0; i < c.size(); i++) {
+                c[i] = 1 / factorial;
+                factorial *= static_cast<double>(i + 1);
+            }
+            return StaticPolynomial<double, 12>(c);
+        }();
+        static_assert(taylor_exp(0.0) == 1.0);
+        const Polynomial<double> dense = taylor_exp.ToDense();
+        std::vector<double> xs(1000000), ys(xs.size());
+        std::uniform_real_distribution<double> dist(-0.5, 0.5);
+        for (auto& x : xs) x = dist(rng);
+        double sink = 0;
+        double dense_ns = time_us([&] {
+            for (double x : xs) sink += dense(x);
+        }) * 1000 / xs.size();
+        double batch_ns = time_us([&] {
+            dense.Evaluate(xs.data(), xs.size(), ys.data());
+            sink += ys[0];
+        }) * 1000 / xs.size();
+        double static_ns = time_us([&] {
+            for (size_t i = 0; i < xs.size(); i++) ys[i] = taylor_exp(xs[i]);
+            sink += ys[0];
+        }) * 1000 / xs.size();
+        // Один длинный ряд зависимых вычислений: здесь решает длина цепочки
+        double x = 0.25, chain_x = 0.25;
+        double dense_chain_ns = time_us([&] {
+            for (int i = 0; i < 1000; i++) x = dense(x) * 0.25;
+        });
+        double static_chain_ns = time_us([&] {
+            for (int i = 0; i < 1000; i++) chain_x = taylor_exp(chain_x) * 0.25;
+        });
+        assert(std::fabs(taylor_exp(0.3) - std::exp(0.3)) < 1e-12);
+        assert(std::fabs(x - chain_x) < 1e-12);
+        std::cout << "   независимые точки: operator() " << dense_ns << ", Evaluate " << batch_ns
+                  << ", StaticPolynomial " << static_ns << '\n';
+        std::cout << "   зависимая цепочка: operator() " << dense_chain_ns << ", StaticPolynomial "
+                  << static_chain_ns << " (sink " << (sink != 0) << ")\n";
+    }
+
     std::cout << "\n🎉 Все тесты пройдены!\n";
     return 0;
 }
\ No newline at end of file
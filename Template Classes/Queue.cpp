@@ -1,7 +1,406 @@
 #include <iostream>
 #include <deque>
 #include <exception>
+#include <stdexcept>
 #include <list>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <thread>
+#include <type_traits>
+
+// Fixed-capacity ring buffer for exactly one producer thread (push_back,
+// try_push) and one consumer thread (front, pop_front, try_pop).
+// Each side keeps a cached copy of the other side's index and only reloads
+// it when the ring looks full/empty, so the shared counters stay mostly
+// in the owner's cache. Iteration and size() are only exact while both
+// threads are quiescent.
+template<typename T, size_t Capacity>
+class SpscRingBuffer {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+
+    alignas(64) std::atomic<size_t> head{0};  // written by the consumer
+    size_t cached_tail = 0;
+
+    alignas(64) std::atomic<size_t> tail{0};  // written by the producer
+    size_t cached_head = 0;
+
+    T* At(size_t i) const {
+        return std::launder(reinterpret_cast<T*>(slots[i & kMask].bytes));
+    }
+
+    template<typename U>
+    bool Emplace(U&& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head >= Capacity) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head == Capacity) {
+                return false;
+            }
+        }
+        ::new (static_cast<void*>(slots[t & kMask].bytes)) T(std::forward<U>(item));
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+public:
+    class iterator {
+    private:
+        const SpscRingBuffer* ring;
+        size_t i;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator(const SpscRingBuffer* ring, size_t i): ring(ring), i(i) {}
+
+        T& operator *() const {
+            return *ring->At(i);
+        }
+
+        iterator& operator ++() {
+            ++i;
+            return *this;
+        }
+
+        iterator operator ++(int) {
+            return iterator(ring, i++);
+        }
+
+        bool operator ==(const iterator& other) const {
+            return i == other.i;
+        }
+
+        bool operator !=(const iterator& other) const {
+            return i != other.i;
+        }
+    };
+
+    SpscRingBuffer():
+        slots(new Slot[Capacity]) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator =(const SpscRingBuffer&) = delete;
+
+    ~SpscRingBuffer() {
+        while (!empty()) {
+            pop_front();
+        }
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return !size();
+    }
+
+    bool try_push(const T& item) {
+        return Emplace(item);
+    }
+
+    bool try_push(T&& item) {
+        return Emplace(std::move(item));
+    }
+
+    bool try_pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h >= cached_tail) {  // pop_front() advances head without the cache
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) {
+                return false;
+            }
+        }
+        T* elem = At(h);
+        item = std::move(*elem);
+        elem->~T();
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push_back(const T& item) {
+        if (!try_push(item)) {
+            throw std::length_error("Full ring buffer!");
+        }
+    }
+
+    T& front() {
+        return *At(head.load(std::memory_order_relaxed));
+    }
+
+    const T& front() const {
+        return *At(head.load(std::memory_order_relaxed));
+    }
+
+    void pop_front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        At(h)->~T();
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    iterator begin() {
+        return iterator(this, head.load(std::memory_order_acquire));
+    }
+
+    iterator end() {
+        return iterator(this, tail.load(std::memory_order_acquire));
+    }
+};
+
+// Ring buffer that keeps up to N elements inside the object and moves to a
+// heap array (doubling) only when it overflows. The heap array is kept once
+// allocated, so a queue that outgrew N does not bounce between the two.
+template<typename T, size_t N>
+class InlineRingBuffer {
+    static_assert(N > 0, "inline capacity must be positive");
+
+private:
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    Slot inline_slots[N];
+    Slot* slots = inline_slots;
+    size_t capacity = N;
+    size_t head = 0;
+    size_t count = 0;
+
+    T* At(size_t k) const {
+        size_t i = head + k;
+        if (i >= capacity) {
+            i -= capacity;
+        }
+        return std::launder(reinterpret_cast<T*>(slots[i].bytes));
+    }
+
+    // Appends item to a doubled array. item may be one of the elements being
+    // moved out, so it is built in the new array before they are.
+    template<typename U>
+    void GrowAndEmplace(U&& item) {
+        std::unique_ptr<Slot[]> fresh(new Slot[capacity * 2]);
+        ::new (static_cast<void*>(fresh[count].bytes)) T(std::forward<U>(item));
+        size_t built = 0;
+        try {
+            for (; built != count; ++built) {
+                ::new (static_cast<void*>(fresh[built].bytes)) T(std::move_if_noexcept(*At(built)));
+            }
+        } catch (...) {
+            // Only copies can throw here, so the old elements are intact.
+            for (size_t k = 0; k != built; ++k) {
+                std::launder(reinterpret_cast<T*>(fresh[k].bytes))->~T();
+            }
+            std::launder(reinterpret_cast<T*>(fresh[count].bytes))->~T();
+            throw;
+        }
+        for (size_t k = 0; k != count; ++k) {
+            At(k)->~T();
+        }
+        if (slots != inline_slots) {
+            delete[] slots;
+        }
+        slots = fresh.release();
+        capacity *= 2;
+        head = 0;
+        ++count;
+    }
+
+    template<typename U>
+    void Emplace(U&& item) {
+        if (count == capacity) {
+            GrowAndEmplace(std::forward<U>(item));
+            return;
+        }
+        ::new (static_cast<void*>(At(count))) T(std::forward<U>(item));
+        ++count;
+    }
+
+public:
+    class iterator {
+    private:
+        const InlineRingBuffer* ring;
+        size_t k;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator(const InlineRingBuffer* ring, size_t k): ring(ring), k(k) {}
+
+        T& operator *() const {
+            return *ring->At(k);
+        }
+
+        iterator& operator ++() {
+            ++k;
+            return *this;
+        }
+
+        iterator operator ++(int) {
+            return iterator(ring, k++);
+        }
+
+        bool operator ==(const iterator& other) const {
+            return k == other.k;
+        }
+
+        bool operator !=(const iterator& other) const {
+            return k != other.k;
+        }
+    };
+
+    InlineRingBuffer() = default;
+
+    InlineRingBuffer(const InlineRingBuffer& other) {
+        try {
+            for (size_t k = 0; k != other.count; ++k) {
+                push_back(*other.At(k));
+            }
+        } catch (...) {
+            // The destructor does not run for a constructor that throws.
+            clear();
+            if (slots != inline_slots) {
+                delete[] slots;
+            }
+            throw;
+        }
+    }
+
+    // Inline elements are moved one by one, so this is noexcept only as far
+    // as T's move is.
+    InlineRingBuffer(InlineRingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (other.slots != other.inline_slots) {
+            slots = std::exchange(other.slots, other.inline_slots);
+            capacity = std::exchange(other.capacity, N);
+            head = std::exchange(other.head, 0);
+            count = std::exchange(other.count, 0);
+            return;
+        }
+        if constexpr (std::is_nothrow_move_constructible_v<T>) {
+            for (T& item : other) {
+                push_back(std::move(item));
+            }
+        } else {
+            try {
+                for (T& item : other) {
+                    push_back(std::move(item));
+                }
+            } catch (...) {
+                clear();
+                throw;
+            }
+        }
+        other.clear();
+    }
+
+    InlineRingBuffer& operator =(InlineRingBuffer other) {
+        clear();
+        if (other.slots != other.inline_slots) {
+            if (slots != inline_slots) {
+                delete[] slots;
+            }
+            slots = std::exchange(other.slots, other.inline_slots);
+            capacity = std::exchange(other.capacity, N);
+            head = std::exchange(other.head, 0);
+            count = std::exchange(other.count, 0);
+        } else {
+            for (T& item : other) {
+                push_back(std::move(item));
+            }
+        }
+        return *this;
+    }
+
+    ~InlineRingBuffer() {
+        clear();
+        if (slots != inline_slots) {
+            delete[] slots;
+        }
+    }
+
+    bool is_inline() const {
+        return slots == inline_slots;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return !count;
+    }
+
+    void push_back(const T& item) {
+        Emplace(item);
+    }
+
+    void push_back(T&& item) {
+        Emplace(std::move(item));
+    }
+
+    T& front() {
+        return *At(0);
+    }
+
+    const T& front() const {
+        return *At(0);
+    }
+
+    void pop_front() {
+        At(0)->~T();
+        if (++head == capacity) {
+            head = 0;
+        }
+        --count;
+    }
+
+    void clear() {
+        while (count) {
+            pop_front();
+        }
+        head = 0;
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, count);
+    }
+};
 
 template<typename T, typename Container = std::deque<T>>
 class Queue {
@@ -35,6 +434,24 @@ public:
         data.push_back(item);
     }
 
+    void push(T&& item) {
+        data.push_back(std::move(item));
+    }
+
+    // Non-throwing pair, available when Container provides it (SpscRingBuffer).
+    bool try_push(const T& item) {
+        return data.try_push(item);
+    }
+
+    // Moves item in only on success; a full buffer leaves it untouched.
+    bool try_push(T&& item) {
+        return data.try_push(std::move(item));
+    }
+
+    bool try_pop(T& item) {
+        return data.try_pop(item);
+    }
+
     size_t size() const {
         return data.size();
     }
@@ -70,6 +487,303 @@ public:
     }
 };
 
+// Delay queue on a hierarchical timing wheel (Varghese & Lauck): kLevels
+// wheels of 64 slots, level L holding deadlines that differ from the current
+// tick first in bits [6L, 6L + 6). Inserting is O(1); an entry is moved down
+// at most kLevels times before it expires, and a 64-bit occupancy mask per
+// level lets Advance jump straight over empty stretches of time.
+// Expired items are pushed into the underlying Queue in deadline order,
+// so front()/pop() see only items that are due.
+template<typename T, typename Container = std::deque<T>>
+class DelayQueue : public Queue<T, Container> {
+private:
+    static constexpr int kBits = 6;
+    static constexpr int kLevels = 4;
+    static constexpr uint64_t kSlots = uint64_t{1} << kBits;
+
+    struct Entry {
+        uint64_t deadline;
+        T item;
+    };
+
+    std::vector<Entry> wheels[kLevels][kSlots];
+    uint64_t masks[kLevels] = {};
+    std::vector<Entry> overflow;  // deadlines beyond the top wheel
+    uint64_t current;
+    size_t waiting = 0;
+
+    void Schedule(Entry&& entry) {
+        if (entry.deadline <= current) {
+            Queue<T, Container>::push(std::move(entry.item));
+            --waiting;
+            return;
+        }
+        int level = (63 - __builtin_clzll(entry.deadline ^ current)) / kBits;
+        if (level >= kLevels) {
+            overflow.push_back(std::move(entry));
+            return;
+        }
+        uint64_t slot = (entry.deadline >> (level * kBits)) & (kSlots - 1);
+        wheels[level][slot].push_back(std::move(entry));
+        masks[level] |= uint64_t{1} << slot;
+    }
+
+    void Reschedule(std::vector<Entry>& bucket) {
+        std::vector<Entry> moved;
+        moved.swap(bucket);
+        for (auto& entry : moved) {
+            Schedule(std::move(entry));
+        }
+        if (bucket.empty()) {  // overflow entries may land back in their bucket
+            moved.clear();
+            bucket.swap(moved);  // keep the capacity for the next round
+        }
+    }
+
+    // First tick at which some slot needs attention, or UINT64_MAX.
+    uint64_t NextEvent() const {
+        for (int level = 0; level < kLevels; ++level) {
+            if (masks[level]) {
+                int shift = level * kBits;
+                uint64_t slot = __builtin_ctzll(masks[level]);
+                return (current >> (shift + kBits) << (shift + kBits)) | (slot << shift);
+            }
+        }
+        if (!overflow.empty()) {
+            return ((current >> (kLevels * kBits)) + 1) << (kLevels * kBits);
+        }
+        return UINT64_MAX;
+    }
+
+    void Tick() {
+        current += 1;
+        if ((current & ((uint64_t{1} << (kLevels * kBits)) - 1)) == 0) {
+            Reschedule(overflow);
+        }
+        for (int level = kLevels - 1; level > 0; --level) {
+            if ((current & ((uint64_t{1} << (level * kBits)) - 1)) == 0) {
+                uint64_t slot = (current >> (level * kBits)) & (kSlots - 1);
+                masks[level] &= ~(uint64_t{1} << slot);
+                Reschedule(wheels[level][slot]);
+            }
+        }
+        uint64_t slot = current & (kSlots - 1);
+        masks[0] &= ~(uint64_t{1} << slot);
+        Reschedule(wheels[0][slot]);
+    }
+
+public:
+    explicit DelayQueue(uint64_t start = 0):
+        current(start) {}
+
+    uint64_t now() const {
+        return current;
+    }
+
+    size_t pending() const {
+        return waiting;
+    }
+
+    void push_at(uint64_t deadline, const T& item) {
+        ++waiting;
+        Schedule(Entry{deadline, item});
+    }
+
+    void push_at(uint64_t deadline, T&& item) {
+        ++waiting;
+        Schedule(Entry{deadline, std::move(item)});
+    }
+
+    // Moves the wheel forward to `now`; time never goes back.
+    void advance(uint64_t now) {
+        while (current < now) {
+            uint64_t next = std::min(NextEvent(), now);
+            if (next > current + 1) {
+                current = next - 1;
+            }
+            Tick();
+        }
+    }
+
+    // Advances to `now` and moves every due item to `out`; returns how many.
+    template<typename OutIter>
+    size_t pop_expired(uint64_t now, OutIter out) {
+        advance(now);
+        size_t popped = 0;
+        for (; !this->empty(); ++popped) {
+            *out++ = std::move(this->front());
+            this->pop();
+        }
+        return popped;
+    }
+};
+
+// Thread-safe queue for many producers and many consumers. Popping takes the
+// front element in one locked step, so there is no front()/pop() race, and
+// the *_many operations move a whole batch under one lock acquisition.
+// After close() pushes throw and pops drain what is left, then return false.
+template<typename T, typename Container = std::deque<T>>
+class ConcurrentQueue {
+private:
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    Container data;
+    bool is_closed = false;
+
+    void CheckOpen() const {
+        if (is_closed) {
+            throw std::logic_error("Closed queue!");
+        }
+    }
+
+    T TakeFront() {
+        T item = std::move(data.front());
+        data.pop_front();
+        return item;
+    }
+
+public:
+    ConcurrentQueue() = default;
+
+    void push(const T& item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            CheckOpen();
+            data.push_back(item);
+        }
+        not_empty.notify_one();
+    }
+
+    void push(T&& item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            CheckOpen();
+            data.push_back(std::move(item));
+        }
+        not_empty.notify_one();
+    }
+
+    // If a copy throws, the elements before it stay in the queue and their
+    // consumers are still woken up.
+    template<typename Iter>
+    void push_many(Iter first, Iter last) {
+        size_t pushed = 0;
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            CheckOpen();
+            try {
+                for (; first != last; ++first, ++pushed) {
+                    data.push_back(*first);
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        if (pushed == 1) {
+            not_empty.notify_one();
+        } else if (pushed > 1) {
+            not_empty.notify_all();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Blocks until an element arrives; false once the queue is closed and drained.
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !data.empty() || is_closed; });
+        if (data.empty()) {
+            return false;
+        }
+        item = TakeFront();
+        return true;
+    }
+
+    template<typename Rep, typename Period>
+    bool pop(T& item, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!not_empty.wait_for(lock, timeout, [this] { return !data.empty() || is_closed; })
+            || data.empty()) {
+            return false;
+        }
+        item = TakeFront();
+        return true;
+    }
+
+    bool try_pop(T& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (data.empty()) {
+            return false;
+        }
+        item = TakeFront();
+        return true;
+    }
+
+    // Blocks for the first element, then takes up to `max` without waiting more.
+    // Returns how many were written to `out`; for max > 0, 0 means closed and
+    // drained. max == 0 returns 0 at once.
+    template<typename OutIter>
+    size_t pop_many(OutIter out, size_t max) {
+        if (max == 0) {
+            return 0;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !data.empty() || is_closed; });
+        size_t popped = 0;
+        for (; popped < max && !data.empty(); ++popped) {
+            *out++ = TakeFront();
+        }
+        return popped;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_closed = true;
+        }
+        not_empty.notify_all();
+    }
+
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return is_closed;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return data.size();
+    }
+
+    bool empty() const {
+        return !size();
+    }
+};
+
+// Global allocation counter for the container benchmarks in main(); atomic
+// because the threaded tests allocate concurrently.
+std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// noinline: inlined into a container's deallocate, GCC 12 reports the
+// free() of a pointer from operator new as -Wmismatched-new-delete, a false
+// positive.
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
 int main() {
     // 1. Пустая очередь
     Queue<int> q1;
@@ -153,6 +867,496 @@ int main() {
     // Queue<int> q_empty;
     // int x = q_empty.front(); // UB или исключение — зависит от реализации
 
+    // 14. Кольцевой буфер фиксированной ёмкости как контейнер
+    Queue<int, SpscRingBuffer<int, 4>> ring;
+    assert(ring.empty());
+    for (int i = 1; i <= 4; ++i) {
+        [[maybe_unused]] const bool pushed = ring.try_push(i);
+        assert(pushed);
+    }
+    [[maybe_unused]] const bool pushed_when_full = ring.try_push(5);
+    assert(!pushed_when_full);
+    [[maybe_unused]] bool throws_on_full = false;
+    try {
+        ring.push(5);
+    } catch (const std::length_error&) {
+        throws_on_full = true;
+    }
+    assert(throws_on_full);
+    assert(ring.front() == 1 && ring.size() == 4);
+    ring.pop();
+    int item = 0;
+    [[maybe_unused]] const bool popped = ring.try_pop(item);
+    assert(popped && item == 2);
+    ring.push(5);
+    ring.push(6);  // индексы переходят через границу буфера
+    Queue<int, SpscRingBuffer<int, 4>> ring2;
+    for (int i = 3; i <= 6; ++i) {
+        ring2.push(i);
+    }
+    assert(ring == ring2);
+    while (ring.try_pop(item)) {
+    }
+    assert(item == 6 && ring.empty());
+    std::cout << "✅ Queue<int, SpscRingBuffer<int, 4>>: try_push/try_pop, переполнение\n";
+
+    Queue<std::string, SpscRingBuffer<std::string, 8>> ring_str;
+    ring_str.push("left in the buffer");  // разрушается деструктором буфера
+    std::cout << "✅ SpscRingBuffer разрушает оставшиеся элементы\n";
+
+    // try_push(T&&): без копии, а при переполнении значение остаётся у вызывающего
+    {
+        Queue<std::unique_ptr<int>, SpscRingBuffer<std::unique_ptr<int>, 2>> owners;
+        for (int i = 0; i < 2; ++i) {
+            auto owner = std::make_unique<int>(i);
+            [[maybe_unused]] const bool pushed = owners.try_push(std::move(owner));
+            assert(pushed && !owner);
+        }
+        auto spare = std::make_unique<int>(7);
+        [[maybe_unused]] const bool pushed = owners.try_push(std::move(spare));
+        assert(!pushed && spare && *spare == 7);
+        std::unique_ptr<int> out;
+        [[maybe_unused]] const bool popped = owners.try_pop(out);
+        assert(popped && *out == 0);
+    }
+    std::cout << "✅ Queue::try_push(T&&): перемещение без копии, переполнение не забирает значение\n";
+
+    // 15. Передача между двумя потоками: кольцо против std::deque под мьютексом
+    const int kItems = 2000000;
+    auto bench = [](const char* name, auto&& run) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        std::cout << "   " << name << ": " << std::fixed << dur.count() << " с\n";
+    };
+    std::cout << "\n⏱  Производитель → потребитель, " << kItems << " элементов:\n";
+    bench("Queue<int, SpscRingBuffer<int, 1024>>", [&] {
+        auto spsc = std::make_unique<Queue<int, SpscRingBuffer<int, 1024>>>();
+        long long sum = 0;
+        std::thread consumer([&] {
+            int x;
+            for (int got = 0; got < kItems;) {
+                if (spsc->try_pop(x)) {
+                    sum += x;
+                    ++got;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (int i = 0; i < kItems; ++i) {
+            while (!spsc->try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+        consumer.join();
+        assert(sum == 1LL * kItems * (kItems - 1) / 2);
+    });
+    bench("Queue<int> + std::mutex            ", [&] {
+        Queue<int> locked;
+        std::mutex mutex;
+        long long sum = 0;
+        std::thread consumer([&] {
+            for (int got = 0; got < kItems;) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!locked.empty()) {
+                    sum += locked.front();
+                    locked.pop();
+                    ++got;
+                } else {
+                    lock.unlock();
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (int i = 0; i < kItems; ++i) {
+            std::lock_guard<std::mutex> lock(mutex);
+            locked.push(i);
+        }
+        consumer.join();
+        assert(sum == 1LL * kItems * (kItems - 1) / 2);
+    });
+
+    // 16. Потокобезопасная очередь: таймауты, пакеты, закрытие
+    ConcurrentQueue<int> cq;
+    int got = 0;
+    [[maybe_unused]] bool received = cq.try_pop(got);
+    assert(!received);
+    received = cq.pop(got, std::chrono::milliseconds(1));
+    assert(!received);
+    std::vector<int> batch = {1, 2, 3, 4, 5};
+    cq.push_many(batch.begin(), batch.end());
+    cq.push(6);
+    assert(cq.size() == 6);
+    std::vector<int> drained;
+    [[maybe_unused]] size_t popped_many = cq.pop_many(std::back_inserter(drained), 0);
+    assert(popped_many == 0 && drained.empty());
+    popped_many = cq.pop_many(std::back_inserter(drained), 4);
+    assert(popped_many == 4);
+    assert(drained == std::vector<int>({1, 2, 3, 4}));
+    received = cq.try_pop(got);
+    assert(received && got == 5);
+    cq.close();
+    [[maybe_unused]] bool throws_on_closed = false;
+    try {
+        cq.push(7);
+    } catch (const std::logic_error&) {
+        throws_on_closed = true;
+    }
+    assert(throws_on_closed && cq.closed());
+    received = cq.pop(got);
+    assert(received && got == 6);
+    received = cq.pop(got);
+    assert(!received);
+    popped_many = cq.pop_many(std::back_inserter(drained), 4);
+    assert(popped_many == 0);
+    std::cout << "✅ ConcurrentQueue: pop с таймаутом, push_many/pop_many, close()\n";
+
+    ConcurrentQueue<std::string> waiting;
+    std::thread waker([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        waiting.push("wake up");
+    });
+    std::string message;
+    received = waiting.pop(message);
+    assert(received && message == "wake up");
+    waker.join();
+    std::cout << "✅ ConcurrentQueue: pop() ждёт производителя\n";
+
+    // Исключение посреди push_many: уже добавленные элементы будят потребителя
+    struct FailingSource {
+        int value;
+        operator std::string() const {
+            if (value < 0) {
+                throw std::runtime_error("bad element");
+            }
+            return std::to_string(value);
+        }
+    };
+    ConcurrentQueue<std::string> partial;
+    std::string first_partial;
+    std::thread partial_consumer([&] {
+        [[maybe_unused]] const bool woken = partial.pop(first_partial);
+        assert(woken);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    FailingSource sources[] = {{1}, {2}, {-1}, {4}};
+    [[maybe_unused]] bool push_many_threw = false;
+    try {
+        partial.push_many(std::begin(sources), std::end(sources));
+    } catch (const std::runtime_error&) {
+        push_many_threw = true;
+    }
+    partial_consumer.join();
+    assert(push_many_threw && first_partial == "1");
+    received = partial.try_pop(message);
+    assert(received && message == "2" && partial.empty());
+    std::cout << "✅ ConcurrentQueue: push_many будит потребителей и при исключении\n";
+
+    // 17. Маленькая очередь без обращений к куче
+    Queue<std::string, InlineRingBuffer<std::string, 4>> small;
+    for (int i = 0; i < 3; ++i) {
+        small.push(std::to_string(i));
+    }
+    small.pop();
+    small.push("3");
+    small.push("4");  // 4 элемента, голова не в нулевой ячейке — кольцо замкнулось
+    Queue<std::string, InlineRingBuffer<std::string, 4>> small_copy(small);
+    assert(small == small_copy);
+    small.push("5");  // переполнение: элементы переезжают в кучу по порядку
+    assert(small.size() == 5 && small.front() == "1");
+    Queue<std::string, InlineRingBuffer<std::string, 4>> small_moved(std::move(small));
+    std::vector<std::string> order;
+    while (!small_moved.empty()) {
+        order.push_back(small_moved.front());
+        small_moved.pop();
+    }
+    assert(order == std::vector<std::string>({"1", "2", "3", "4", "5"}));
+    small_copy = small_moved;
+    assert(small_copy.empty());
+    static_assert(std::is_nothrow_move_constructible_v<InlineRingBuffer<std::string, 4>>);
+    std::cout << "✅ Queue<std::string, InlineRingBuffer<std::string, 4>>: кольцо, переполнение, копирование\n";
+
+    // Исключение при переезде в кучу не оставляет живых копий
+    {
+        static int live = 0;
+        static int copies_until_throw = -1;
+        struct Fragile {
+            Fragile() {
+                ++live;
+            }
+            Fragile(const Fragile&) {
+                if (copies_until_throw-- == 0) {
+                    throw std::runtime_error("copy failed");
+                }
+                ++live;
+            }
+            Fragile(Fragile&& other) : Fragile(static_cast<const Fragile&>(other)) {}  // не noexcept: Grow копирует
+            ~Fragile() {
+                --live;
+            }
+        };
+        {
+            InlineRingBuffer<Fragile, 4> ring;
+            for (int i = 0; i < 4; ++i) {
+                ring.push_back(Fragile());
+            }
+            copies_until_throw = 2;
+            [[maybe_unused]] bool grow_failed = false;
+            try {
+                ring.push_back(Fragile());
+            } catch (const std::runtime_error&) {
+                grow_failed = true;
+            }
+            copies_until_throw = -1;
+            assert(grow_failed && live == 4 && ring.size() == 4 && ring.is_inline());
+            for (int i = 0; i < 2; ++i) {
+                ring.push_back(Fragile());
+            }
+            copies_until_throw = 3;
+            [[maybe_unused]] bool copy_failed = false;
+            try {
+                InlineRingBuffer<Fragile, 4> copy(ring);
+            } catch (const std::runtime_error&) {
+                copy_failed = true;
+            }
+            copies_until_throw = -1;
+            assert(copy_failed && live == 6);  // копирование из кучи не утекло
+        }
+        assert(live == 0);
+    }
+    std::cout << "✅ InlineRingBuffer: исключение при росте и копировании не оставляет лишних элементов\n";
+
+    // push(front()) в заполненную очередь: новый элемент строится до переезда старых
+    {
+        Queue<std::string, InlineRingBuffer<std::string, 2>> q;
+        q.push(std::string(40, 'a'));
+        q.push(std::string(40, 'b'));
+        for (int round = 0; round < 3; ++round) {  // переезд в кучу, затем два удвоения кучи
+            const size_t size = q.size();
+            while (q.size() != 2 * size) {
+                q.push(q.front());
+            }
+        }
+        assert(q.size() == 16);
+        std::string order;
+        while (!q.empty()) {
+            assert(q.front().size() == 40);
+            order += q.front()[0];
+            q.pop();
+        }
+        assert(order == "ab" + std::string(14, 'a'));
+    }
+    std::cout << "✅ InlineRingBuffer: push(front()) при переполнении сохраняет значение\n";
+
+    // 18. Аллокации и время: 10^6 коротких очередей по 12 элементов
+    std::cout << "\n⏱  10^6 очередей по 12 элементов (аллокаций / время):\n";
+    auto bench_small = [](const char* name, auto make_queue) {
+        size_t before = allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        long long sum = 0;
+        for (int round = 0; round < 1000000; ++round) {
+            auto q = make_queue();
+            for (int i = 0; i < 12; ++i) {
+                q.push(i);
+            }
+            while (!q.empty()) {
+                sum += q.front();
+                q.pop();
+            }
+        }
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        assert(sum == 66LL * 1000000);
+        std::cout << "   " << name << ": " << allocations - before << " / " << std::fixed << dur.count() << " с\n";
+    };
+    bench_small("Queue<int>                         ", [] { return Queue<int>(); });
+    bench_small("Queue<int, std::list<int>>         ", [] { return Queue<int, std::list<int>>(); });
+    bench_small("Queue<int, InlineRingBuffer<int, 16>>", [] { return Queue<int, InlineRingBuffer<int, 16>>(); });
+
+    // 19. Очередь с дедлайнами на иерархическом колесе таймеров
+    DelayQueue<std::string> timers(100);
+    timers.push_at(90, "overdue");
+    timers.push_at(105, "b");
+    timers.push_at(101, "a");
+    timers.push_at(100 + 64 * 64 + 3, "level 2");
+    timers.push_at(100 + (uint64_t{1} << 30), "overflow");
+    std::vector<std::string> fired;
+    assert(timers.front() == "overdue" && timers.pending() == 4);
+    [[maybe_unused]] size_t fired_now = timers.pop_expired(104, std::back_inserter(fired));
+    assert(fired_now == 2);
+    assert(fired == std::vector<std::string>({"overdue", "a"}));
+    timers.pop_expired(105, std::back_inserter(fired));
+    assert(fired.back() == "b");
+    fired_now = timers.pop_expired(100 + 64 * 64 + 2, std::back_inserter(fired));
+    assert(fired_now == 0);
+    fired_now = timers.pop_expired(100 + 64 * 64 + 3, std::back_inserter(fired));
+    assert(fired_now == 1);
+    assert(fired.back() == "level 2");
+    fired_now = timers.pop_expired(100 + (uint64_t{1} << 30) - 1, std::back_inserter(fired));
+    assert(fired_now == 0);
+    fired_now = timers.pop_expired(uint64_t{1} << 40, std::back_inserter(fired));
+    assert(fired_now == 1);
+    assert(fired.back() == "overflow" && timers.pending() == 0 && timers.now() == uint64_t{1} << 40);
+    std::cout << "✅ DelayQueue: push_at/pop_expired, каскады между уровнями и дальние дедлайны\n";
+
+    std::mt19937_64 rng(7);
+    DelayQueue<uint64_t> checked;
+    std::vector<uint64_t> deadlines;
+    for (int i = 0; i < 20000; ++i) {
+        deadlines.push_back(rng() % 2000000);
+        checked.push_at(deadlines.back(), deadlines.back());
+    }
+    std::sort(deadlines.begin(), deadlines.end());
+    std::vector<uint64_t> expired;
+    for (uint64_t now = 0; expired.size() < deadlines.size(); now += rng() % 5000) {
+        size_t before = expired.size();
+        checked.pop_expired(now, std::back_inserter(expired));
+        for (size_t i = before; i < expired.size(); ++i) {
+            assert(expired[i] <= now);
+        }
+        assert(expired.size() == static_cast<size_t>(std::upper_bound(deadlines.begin(), deadlines.end(), now) - deadlines.begin()));
+    }
+    assert(expired == deadlines);
+    std::cout << "✅ DelayQueue: 20000 случайных дедлайнов срабатывают вовремя и по порядку\n";
+
+    // 20. Колесо против двоичной кучи: 300000 таймеров, шаг в один тик
+    std::cout << "\n⏱  300000 таймеров, 10^6 тиков:\n";
+    const uint64_t kTicks = 1000000;
+    std::vector<uint64_t> timeouts(300000);
+    for (auto& t : timeouts) {
+        t = rng() % kTicks;
+    }
+    bench("DelayQueue (timing wheel)   ", [&] {
+        DelayQueue<int> wheel;
+        for (size_t i = 0; i < timeouts.size(); ++i) {
+            wheel.push_at(timeouts[i], static_cast<int>(i));
+        }
+        std::vector<int> out;
+        size_t total = 0;
+        for (uint64_t now = 1; now <= kTicks; ++now) {
+            out.clear();
+            total += wheel.pop_expired(now, std::back_inserter(out));
+        }
+        assert(total == timeouts.size());
+    });
+    bench("std::priority_queue (heap)  ", [&] {
+        using item = std::pair<uint64_t, int>;
+        std::priority_queue<item, std::vector<item>, std::greater<item>> heap;
+        for (size_t i = 0; i < timeouts.size(); ++i) {
+            heap.emplace(timeouts[i], static_cast<int>(i));
+        }
+        std::vector<int> out;
+        size_t total = 0;
+        for (uint64_t now = 1; now <= kTicks; ++now) {
+            out.clear();
+            while (!heap.empty() && heap.top().first <= now) {
+                out.push_back(heap.top().second);
+                heap.pop();
+                ++total;
+            }
+        }
+        assert(total == timeouts.size());
+    });
+
+    // 21. Пропускная способность по одному элементу и пакетами по 64. Производители
+    // не ждут потребителей, поэтому очередь насыщена и измеряемое время — это
+    // ожидание в накопившейся очереди, а не задержка передачи одного элемента.
+    std::cout << "\n⏱  ConcurrentQueue, N производителей и N потребителей:\n";
+    const int kMessages = 400000;
+    const int kBatch = 64;
+    const unsigned max_threads = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        for (bool batched : {false, true}) {
+            using clock = std::chrono::steady_clock;
+            ConcurrentQueue<clock::time_point> mpmc;
+            std::atomic<long long> latency_ns{0};
+            std::atomic<int> received{0};
+            auto start = clock::now();
+            std::vector<std::thread> consumers, producers;
+            for (unsigned k = 0; k < threads; ++k) {
+                consumers.emplace_back([&] {
+                    std::vector<clock::time_point> buffer;
+                    long long local_latency = 0;
+                    int local_received = 0;
+                    clock::time_point stamp;
+                    while (true) {
+                        buffer.clear();
+                        if (batched) {
+                            if (!mpmc.pop_many(std::back_inserter(buffer), kBatch)) {
+                                break;
+                            }
+                        } else {
+                            if (!mpmc.pop(stamp)) {
+                                break;
+                            }
+                            buffer.push_back(stamp);
+                        }
+                        auto now = clock::now();
+                        for (const auto& sent : buffer) {
+                            local_latency += std::chrono::duration_cast<std::chrono::nanoseconds>(now - sent).count();
+                        }
+                        local_received += static_cast<int>(buffer.size());
+                    }
+                    latency_ns += local_latency;
+                    received += local_received;
+                });
+            }
+            for (unsigned k = 0; k < threads; ++k) {
+                producers.emplace_back([&] {
+                    const int share = kMessages / static_cast<int>(threads);
+                    std::vector<clock::time_point> buffer;
+                    for (int i = 0; i < share;) {
+                        if (batched) {
+                            buffer.assign(std::min(kBatch, share - i), clock::now());
+                            mpmc.push_many(buffer.begin(), buffer.end());
+                            i += static_cast<int>(buffer.size());
+                        } else {
+                            mpmc.push(clock::now());
+                            ++i;
+                        }
+                    }
+                });
+            }
+            for (auto& t : producers) {
+                t.join();
+            }
+            mpmc.close();
+            for (auto& t : consumers) {
+                t.join();
+            }
+            std::chrono::duration<double> dur = clock::now() - start;
+            int total = received.load();
+            assert(total == kMessages / static_cast<int>(threads) * static_cast<int>(threads));
+            std::cout << "   потоков: " << threads << "+" << threads
+                      << (batched ? "  пакетами: " : "  по одному: ") << std::fixed
+                      << total / dur.count() / 1e6 << " млн/с, время в очереди "
+                      << latency_ns.load() / total / 1000.0 << " мкс\n";
+        }
+    }
+
+    // Задержка передачи: один элемент туда и обратно между двумя потоками
+    {
+        const int kRoundTrips = 20000;
+        ConcurrentQueue<int> ping, pong;
+        std::thread echo([&] {
+            int value = 0;
+            while (ping.pop(value)) {
+                pong.push(value);
+            }
+        });
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRoundTrips; ++i) {
+            int value = -1;
+            ping.push(i);
+            [[maybe_unused]] const bool echoed = pong.pop(value);
+            assert(echoed && value == i);
+        }
+        std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - start;
+        ping.close();
+        echo.join();
+        std::cout << "   туда и обратно по одному элементу: " << dur.count() / kRoundTrips << " мкс\n";
+    }
+
     std::cout << "\n✅ Все тесты пройдены!" << std::endl;
 
     return 0;
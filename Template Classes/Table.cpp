@@ -1,41 +1,1134 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+// All cells live in one row-major buffer: row r starts at r * stride, and
+// stride >= columns leaves room to widen rows in place. resize() reshapes
+// within the current capacity without moving anything and reallocates only
+// when the new shape does not fit. Cells are a plain T[] rather than a
+// std::vector<T>, so Table<bool> keeps real bool cells that RowSpan can point
+// into.
 template<typename T>
 class Table {
 private:
     size_t columns, rows;
-    std::vector<std::vector<T>> data;
+    size_t stride = 0;        // allocated cells per row
+    size_t row_capacity = 0;  // allocated rows
+    std::unique_ptr<T[]> data;
+
+    void Reallocate(const size_t new_row_capacity, const size_t new_stride) {
+        std::unique_ptr<T[]> fresh(new T[new_row_capacity * new_stride]());
+        for (size_t r = 0; r < rows; ++r) {
+            std::move(data.get() + r * stride, data.get() + r * stride + columns, fresh.get() + r * new_stride);
+        }
+        data.swap(fresh);
+        row_capacity = new_row_capacity;
+        stride = new_stride;
+    }
+
 public:
+    // A view of one row; stays valid until the next resize or reserve.
+    template<bool IsConst>
+    class RowSpan {
+    private:
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        pointer first;
+        size_t length;
+
+    public:
+        RowSpan(pointer first, const size_t length):
+            first(first),
+            length(length) {}
+
+        operator RowSpan<true>() const {
+            return RowSpan<true>(first, length);
+        }
+
+        reference operator[](const size_t c) const {
+            return first[c];
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        pointer data() const {
+            return first;
+        }
+
+        pointer begin() const {
+            return first;
+        }
+
+        pointer end() const {
+            return first + length;
+        }
+    };
+
+    using Row = RowSpan<false>;
+    using ConstRow = RowSpan<true>;
+
     Table(const size_t rows, const size_t columns):
         columns(columns),
-        rows(rows)
-    {
-        data.assign(rows, std::vector<T>(columns));
+        rows(rows),
+        stride(columns),
+        row_capacity(rows),
+        data(new T[rows * columns]()) {}
+
+    // Copies only the rows x columns cells; the copy has no spare capacity.
+    Table(const Table& other):
+        columns(other.columns),
+        rows(other.rows),
+        stride(other.columns),
+        row_capacity(other.rows),
+        data(new T[other.rows * other.columns]()) {
+        for (size_t r = 0; r < rows; ++r) {
+            std::copy(other.data.get() + r * other.stride, other.data.get() + r * other.stride + columns,
+                      data.get() + r * stride);
+        }
+    }
+
+    // Leaves other a 0 x 0 table with no capacity.
+    Table(Table&& other) noexcept:
+        columns(std::exchange(other.columns, 0)),
+        rows(std::exchange(other.rows, 0)),
+        stride(std::exchange(other.stride, 0)),
+        row_capacity(std::exchange(other.row_capacity, 0)),
+        data(std::move(other.data)) {}
+
+    Table& operator=(const Table& other) {
+        Table copy(other);
+        return *this = std::move(copy);
     }
 
-    const std::vector<T>& operator[](const size_t r) const {
-        return data[r];
+    Table& operator=(Table&& other) noexcept {
+        columns = std::exchange(other.columns, 0);
+        rows = std::exchange(other.rows, 0);
+        stride = std::exchange(other.stride, 0);
+        row_capacity = std::exchange(other.row_capacity, 0);
+        data = std::move(other.data);
+        return *this;
     }
 
-    std::vector<T>& operator[](const size_t r) {
-        return data[r];
+    ConstRow operator[](const size_t r) const {
+        return ConstRow(data.get() + r * stride, columns);
     }
 
+    Row operator[](const size_t r) {
+        return Row(data.get() + r * stride, columns);
+    }
+
+    // Allocates room for a rows x columns shape without changing the size.
+    void reserve(const size_t rows, const size_t columns) {
+        if (rows > row_capacity || columns > stride) {
+            Reallocate(std::max(rows, row_capacity), std::max(columns, stride));
+        }
+    }
+
+    // Keeps the overlapping cells; all other cells become T().
     void resize(const size_t rows, const size_t columns) {
+        if (rows > row_capacity || columns > stride) {
+            // Rows grow geometrically, like std::vector; columns grow exactly.
+            Reallocate(rows > row_capacity ? std::max(rows, row_capacity * 2) : row_capacity, std::max(columns, stride));
+        }
+        // Cells outside the old shape may hold stale values from before a shrink.
+        for (size_t r = 0; r < std::min(rows, this->rows); ++r) {
+            if (columns > this->columns) {
+                std::fill(data.get() + r * stride + this->columns, data.get() + r * stride + columns, T());
+            }
+        }
+        for (size_t r = this->rows; r < rows; ++r) {
+            std::fill(data.get() + r * stride, data.get() + r * stride + columns, T());
+        }
         this->rows = rows;
         this->columns = columns;
-        data.resize(rows);
-        for (auto& row : data) {
-            row.resize(columns);
+    }
+
+    std::pair<size_t, size_t> size() const {
+        return std::make_pair(rows, columns);
+    }
+
+    std::pair<size_t, size_t> capacity() const {
+        return std::make_pair(row_capacity, stride);
+    }
+
+    // Distance in elements between the starts of consecutive rows.
+    size_t Stride() const {
+        return stride;
+    }
+
+    // Calls fn(row_begin, row_end, column_begin, column_end) for every tile
+    // of at most tile_rows x tile_columns cells, tile rows in order. Column
+    // passes done tile by tile touch each cache line once instead of once
+    // per row. Throws std::invalid_argument for a zero tile size.
+    template<typename F>
+    void ForEachTile(const size_t tile_rows, const size_t tile_columns, F fn) const;
+
+    // A new columns x rows table, built tile by tile so that the cache lines
+    // a tile reads and writes stay in L1 until they are used up. Trivially
+    // copyable 4-byte cells are transposed 4x4 in SSE2 registers, and 8-byte
+    // cells 2x2.
+    Table Transpose() const;
+
+private:
+    static void TransposeTile(const T* from, const size_t from_stride, T* to, const size_t to_stride,
+                              const size_t tile_rows, const size_t tile_columns);
+};
+
+template<typename T>
+template<typename F>
+void Table<T>::ForEachTile(const size_t tile_rows, const size_t tile_columns, F fn) const {
+    if (tile_rows == 0 || tile_columns == 0) {
+        throw std::invalid_argument("Zero tile size!");
+    }
+    for (size_t r = 0; r < rows; r += tile_rows) {
+        for (size_t c = 0; c < columns; c += tile_columns) {
+            fn(r, std::min(rows, r + tile_rows), c, std::min(columns, c + tile_columns));
+        }
+    }
+}
+
+template<typename T>
+void Table<T>::TransposeTile(const T* from, const size_t from_stride, T* to, const size_t to_stride,
+                             const size_t tile_rows, const size_t tile_columns) {
+    size_t r = 0;
+#ifdef __SSE2__
+    if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) == 4) {
+        for (; r + 4 <= tile_rows; r += 4) {
+            size_t c = 0;
+            for (; c + 4 <= tile_columns; c += 4) {
+                auto load = [&](size_t i) {
+                    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + (r + i) * from_stride + c));
+                };
+                __m128i a0 = load(0), a1 = load(1), a2 = load(2), a3 = load(3);
+                __m128i t0 = _mm_unpacklo_epi32(a0, a1);
+                __m128i t1 = _mm_unpacklo_epi32(a2, a3);
+                __m128i t2 = _mm_unpackhi_epi32(a0, a1);
+                __m128i t3 = _mm_unpackhi_epi32(a2, a3);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(to + c * to_stride + r), _mm_unpacklo_epi64(t0, t1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(to + (c + 1) * to_stride + r), _mm_unpackhi_epi64(t0, t1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(to + (c + 2) * to_stride + r), _mm_unpacklo_epi64(t2, t3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(to + (c + 3) * to_stride + r), _mm_unpackhi_epi64(t2, t3));
+            }
+            for (; c < tile_columns; ++c) {
+                for (size_t i = r; i < r + 4; ++i) {
+                    to[c * to_stride + i] = from[i * from_stride + c];
+                }
+            }
+        }
+    } else if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) == 8) {
+        for (; r + 2 <= tile_rows; r += 2) {
+            size_t c = 0;
+            for (; c + 2 <= tile_columns; c += 2) {
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + r * from_stride + c));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + (r + 1) * from_stride + c));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(to + c * to_stride + r), _mm_unpacklo_epi64(a0, a1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(to + (c + 1) * to_stride + r), _mm_unpackhi_epi64(a0, a1));
+            }
+            for (; c < tile_columns; ++c) {
+                to[c * to_stride + r] = from[r * from_stride + c];
+                to[c * to_stride + r + 1] = from[(r + 1) * from_stride + c];
+            }
+        }
+    }
+#endif
+    for (; r < tile_rows; ++r) {
+        for (size_t c = 0; c < tile_columns; ++c) {
+            to[c * to_stride + r] = from[r * from_stride + c];
+        }
+    }
+}
+
+template<typename T>
+Table<T> Table<T>::Transpose() const {
+    Table result(columns, rows);
+    // A tile is one cache line wide in the source and 1 KB wide in the
+    // destination. A square tile at a power-of-two stride maps all of its
+    // rows to the same L1 set and thrashes.
+    const size_t tile_rows = std::max<size_t>(1024 / sizeof(T), 4);
+    const size_t tile_columns = std::max<size_t>(64 / sizeof(T), 4);
+    ForEachTile(tile_rows, tile_columns, [&](size_t r0, size_t r1, size_t c0, size_t c1) {
+        TransposeTile(data.get() + r0 * stride + c0, stride, result.data.get() + c0 * result.stride + r0, result.stride,
+                      r1 - r0, c1 - c0);
+    });
+    return result;
+}
+
+// Minimal allocator returning Alignment-aligned storage, so that every
+// ColumnarTable column starts on a cache line.
+template<typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(const size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* const p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    bool operator==(const AlignedAllocator&) const {
+        return true;
+    }
+
+    bool operator!=(const AlignedAllocator&) const {
+        return false;
+    }
+};
+
+// GCC/Clang vector extension over T: one 16-byte SIMD register. The column
+// kernels keep kUnroll of them in flight as independent accumulators.
+template<typename T>
+struct Simd {
+    typedef T Vector __attribute__((vector_size(16)));
+    using Mask = decltype(Vector{} < Vector{});  // lanes are all ones (-1) or zero
+
+    static constexpr size_t kLanes = sizeof(Vector) / sizeof(T);
+    static constexpr size_t kUnroll = 4;
+    static constexpr size_t kBlock = kLanes * kUnroll;
+
+    static Vector Load(const T* p) {
+        Vector v;
+        __builtin_memcpy(&v, p, sizeof(v));
+        return v;
+    }
+};
+
+// Column-major (SoA) counterpart of Table: each column is its own
+// contiguous, 64-byte-aligned array, so a query touching two columns reads
+// only those two. The aggregates run over whole SIMD vectors of a column.
+// Predicates are called both with a T (for the tail) and with a
+// Simd<T>::Vector, so write them as generic lambdas built from comparisons
+// and & | ~, e.g. [](auto x) { return (x > 10) & (x < 20); }.
+template<typename T>
+class ColumnarTable {
+private:
+    size_t columns, rows;
+    std::vector<std::vector<T, AlignedAllocator<T, 64>>> data;
+
+public:
+    ColumnarTable(const size_t rows, const size_t columns):
+        columns(columns),
+        rows(rows),
+        data(columns, std::vector<T, AlignedAllocator<T, 64>>(rows)) {}
+
+    explicit ColumnarTable(const Table<T>& table):
+        ColumnarTable(table.size().first, table.size().second) {
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < columns; ++c) {
+                data[c][r] = table[r][c];
+            }
+        }
+    }
+
+    Table<T> ToTable() const {
+        Table<T> table(rows, columns);
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < columns; ++c) {
+                table[r][c] = data[c][r];
+            }
+        }
+        return table;
+    }
+
+    const T& operator()(const size_t r, const size_t c) const {
+        return data[c][r];
+    }
+
+    T& operator()(const size_t r, const size_t c) {
+        return data[c][r];
+    }
+
+    // The size().first cells of column c.
+    const T* Column(const size_t c) const {
+        return data[c].data();
+    }
+
+    T* Column(const size_t c) {
+        return data[c].data();
+    }
+
+    void resize(const size_t rows, const size_t columns) {
+        this->rows = rows;
+        this->columns = columns;
+        data.resize(columns);
+        for (auto& column : data) {
+            column.resize(rows);
         }
     }
 
     std::pair<size_t, size_t> size() const {
         return std::make_pair(rows, columns);
     }
+
+    // Accumulates in T, so choose T wide enough for the column total.
+    T Sum(const size_t c) const;
+
+    T Min(const size_t c) const;  // throws std::out_of_range on an empty table
+
+    T Max(const size_t c) const;  // throws std::out_of_range on an empty table
+
+    template<typename Pred>
+    size_t CountIf(const size_t c, Pred pred) const;
+
+    // Sum of column `sum_column` over the rows where pred(column `filter_column`) holds.
+    template<typename Pred>
+    T SumIf(const size_t sum_column, const size_t filter_column, Pred pred) const;
 };
 
+template<typename T>
+T ColumnarTable<T>::Sum(const size_t c) const {
+    using S = Simd<T>;
+    const T* p = Column(c);
+    typename S::Vector acc[S::kUnroll] = {};
+    size_t i = 0;
+    for (; i + S::kBlock <= rows; i += S::kBlock) {
+        for (size_t k = 0; k < S::kUnroll; ++k) {
+            acc[k] += S::Load(p + i + k * S::kLanes);
+        }
+    }
+    T total = T();
+    for (size_t k = 0; k < S::kUnroll; ++k) {
+        for (size_t l = 0; l < S::kLanes; ++l) {
+            total += acc[k][l];
+        }
+    }
+    for (; i < rows; ++i) {
+        total += p[i];
+    }
+    return total;
+}
+
+template<typename T>
+T ColumnarTable<T>::Min(const size_t c) const {
+    using S = Simd<T>;
+    if (!rows) {
+        throw std::out_of_range("Empty column!");
+    }
+    const T* p = Column(c);
+    typename S::Vector acc[S::kUnroll];
+    std::fill_n(acc, S::kUnroll, typename S::Vector{} + p[0]);
+    size_t i = 0;
+    for (; i + S::kBlock <= rows; i += S::kBlock) {
+        for (size_t k = 0; k < S::kUnroll; ++k) {
+            typename S::Vector v = S::Load(p + i + k * S::kLanes);
+            acc[k] = v < acc[k] ? v : acc[k];
+        }
+    }
+    T result = p[0];
+    for (size_t k = 0; k < S::kUnroll; ++k) {
+        for (size_t l = 0; l < S::kLanes; ++l) {
+            result = std::min(result, static_cast<T>(acc[k][l]));
+        }
+    }
+    for (; i < rows; ++i) {
+        result = std::min(result, p[i]);
+    }
+    return result;
+}
+
+template<typename T>
+T ColumnarTable<T>::Max(const size_t c) const {
+    using S = Simd<T>;
+    if (!rows) {
+        throw std::out_of_range("Empty column!");
+    }
+    const T* p = Column(c);
+    typename S::Vector acc[S::kUnroll];
+    std::fill_n(acc, S::kUnroll, typename S::Vector{} + p[0]);
+    size_t i = 0;
+    for (; i + S::kBlock <= rows; i += S::kBlock) {
+        for (size_t k = 0; k < S::kUnroll; ++k) {
+            typename S::Vector v = S::Load(p + i + k * S::kLanes);
+            acc[k] = v > acc[k] ? v : acc[k];
+        }
+    }
+    T result = p[0];
+    for (size_t k = 0; k < S::kUnroll; ++k) {
+        for (size_t l = 0; l < S::kLanes; ++l) {
+            result = std::max(result, static_cast<T>(acc[k][l]));
+        }
+    }
+    for (; i < rows; ++i) {
+        result = std::max(result, p[i]);
+    }
+    return result;
+}
+
+template<typename T>
+template<typename Pred>
+size_t ColumnarTable<T>::CountIf(const size_t c, Pred pred) const {
+    using S = Simd<T>;
+    // Narrow mask lanes (int8_t for char columns) would overflow, so the
+    // per-lane counts are flushed every 127 blocks.
+    const size_t kFlush = 127 * S::kBlock;
+    const size_t full = rows - rows % S::kBlock;
+    const T* p = Column(c);
+    size_t count = 0;
+    size_t i = 0;
+    while (i < full) {
+        typename S::Mask hits[S::kUnroll] = {};
+        for (size_t stop = std::min(full, i + kFlush); i < stop; i += S::kBlock) {
+            for (size_t k = 0; k < S::kUnroll; ++k) {
+                hits[k] -= pred(S::Load(p + i + k * S::kLanes));
+            }
+        }
+        for (size_t k = 0; k < S::kUnroll; ++k) {
+            for (size_t l = 0; l < S::kLanes; ++l) {
+                count += static_cast<size_t>(hits[k][l]);
+            }
+        }
+    }
+    for (; i < rows; ++i) {
+        count += pred(p[i]) ? 1 : 0;
+    }
+    return count;
+}
+
+template<typename T>
+template<typename Pred>
+T ColumnarTable<T>::SumIf(const size_t sum_column, const size_t filter_column, Pred pred) const {
+    using S = Simd<T>;
+    const T* values = Column(sum_column);
+    const T* keys = Column(filter_column);
+    typename S::Vector acc[S::kUnroll] = {};
+    size_t i = 0;
+    for (; i + S::kBlock <= rows; i += S::kBlock) {
+        for (size_t k = 0; k < S::kUnroll; ++k) {
+            size_t at = i + k * S::kLanes;
+            acc[k] += pred(S::Load(keys + at)) ? S::Load(values + at) : typename S::Vector{};
+        }
+    }
+    T total = T();
+    for (size_t k = 0; k < S::kUnroll; ++k) {
+        for (size_t l = 0; l < S::kLanes; ++l) {
+            total += acc[k][l];
+        }
+    }
+    for (; i < rows; ++i) {
+        if (pred(keys[i])) {
+            total += values[i];
+        }
+    }
+    return total;
+}
+
+// Hash group-by and inner equi-join over Table<T>. Rows are first
+// radix-partitioned by the top bits of their key hash, with a partition
+// count chosen so that each partition's hash table stays cache-resident.
+// The partitions are then processed independently on `threads` threads.
+// Keys are hashed with std::hash<T> and compared with ==.
+template<typename T>
+class QueryEngine {
+public:
+    enum class Aggregate { kCount, kSum, kMin, kMax };
+
+    struct AggregateSpec {
+        Aggregate op;
+        size_t column;  // ignored by kCount
+    };
+
+    explicit QueryEngine(const size_t threads = std::max(1u, std::thread::hardware_concurrency())):
+        threads(std::max<size_t>(threads, 1)) {}
+
+    // One row per distinct key: the key, then one column per aggregate.
+    // Row order is unspecified.
+    Table<T> GroupBy(const Table<T>& table, const size_t key_column, const std::vector<AggregateSpec>& aggregates) const;
+
+    // One row per matching pair: the probe row's columns, then the build
+    // row's. Row order is unspecified. The build side should be the smaller one.
+    Table<T> Join(const Table<T>& build, const size_t build_key, const Table<T>& probe, const size_t probe_key) const;
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr size_t kPartitionRows = 8192;  // target rows per partition
+
+    struct Entry {
+        T key;
+        size_t row;
+    };
+
+    size_t threads;
+
+    static uint64_t Hash(const T& key) {
+        uint64_t h = static_cast<uint64_t>(std::hash<T>()(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static unsigned RadixBits(const size_t rows) {
+        unsigned bits = 0;
+        while (bits < 10 && (rows >> bits) > kPartitionRows) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    static size_t PartitionOf(const uint64_t hash, const unsigned bits) {
+        return bits ? static_cast<size_t>(hash >> (64 - bits)) : 0;
+    }
+
+    static size_t TableCapacity(const size_t rows) {
+        size_t capacity = 1;
+        while (capacity < 2 * rows) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    // Calls fn(i) for every i in [0, n) on up to `threads` threads started
+    // for this call. The first exception thrown by fn stops the remaining
+    // calls and is rethrown here once all threads have joined.
+    template<typename F>
+    void ParallelFor(const size_t n, F fn) const;
+
+    // Scatters (key, row) for every row into 2^bits partitions; partition p
+    // is out[offsets[p], offsets[p + 1]). Each thread histograms and then
+    // scatters its own chunk of rows, so the scatter needs no locking.
+    void Partition(const Table<T>& table, const size_t key_column, const unsigned bits,
+                   std::vector<Entry>& out, std::vector<size_t>& offsets) const;
+};
+
+template<typename T>
+template<typename F>
+void QueryEngine<T>::ParallelFor(const size_t n, F fn) const {
+    size_t workers = std::min(threads, n);
+    if (workers <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto stop = [&](std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+            error = e;
+        }
+        next = n;
+    };
+    std::vector<std::thread> pool;
+    try {
+        for (size_t w = 0; w < workers; ++w) {
+            pool.emplace_back([&] {
+                try {
+                    for (size_t i = next++; i < n; i = next++) {
+                        fn(i);
+                    }
+                } catch (...) {
+                    stop(std::current_exception());
+                }
+            });
+        }
+    } catch (...) {
+        stop(std::current_exception());
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+template<typename T>
+void QueryEngine<T>::Partition(const Table<T>& table, const size_t key_column, const unsigned bits,
+                               std::vector<Entry>& out, std::vector<size_t>& offsets) const {
+    const size_t rows = table.size().first;
+    const size_t parts = size_t{1} << bits;
+    const size_t chunks = std::max<size_t>(1, std::min(threads, rows / kPartitionRows));
+    const size_t chunk_rows = (rows + chunks - 1) / chunks;
+    std::vector<std::vector<size_t>> cursor(chunks, std::vector<size_t>(parts, 0));
+    ParallelFor(chunks, [&](size_t c) {
+        for (size_t r = c * chunk_rows; r < std::min(rows, (c + 1) * chunk_rows); ++r) {
+            ++cursor[c][PartitionOf(Hash(table[r][key_column]), bits)];
+        }
+    });
+    offsets.assign(parts + 1, 0);
+    size_t total = 0;
+    for (size_t p = 0; p < parts; ++p) {
+        offsets[p] = total;
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t count = cursor[c][p];
+            cursor[c][p] = total;
+            total += count;
+        }
+    }
+    offsets[parts] = total;
+    out.resize(rows);
+    ParallelFor(chunks, [&](size_t c) {
+        for (size_t r = c * chunk_rows; r < std::min(rows, (c + 1) * chunk_rows); ++r) {
+            const T& key = table[r][key_column];
+            out[cursor[c][PartitionOf(Hash(key), bits)]++] = Entry{key, r};
+        }
+    });
+}
+
+template<typename T>
+Table<T> QueryEngine<T>::GroupBy(const Table<T>& table, const size_t key_column, const std::vector<AggregateSpec>& aggregates) const {
+    const size_t width = 1 + aggregates.size();
+    const unsigned bits = RadixBits(table.size().first);
+    std::vector<Entry> entries;
+    std::vector<size_t> offsets;
+    Partition(table, key_column, bits, entries, offsets);
+
+    // groups[p] holds partition p's result rows back to back.
+    std::vector<std::vector<T>> groups(offsets.size() - 1);
+    ParallelFor(groups.size(), [&](size_t p) {
+        const size_t capacity = TableCapacity(offsets[p + 1] - offsets[p]);
+        std::vector<uint32_t> slots(capacity, kNone);
+        std::vector<T>& out = groups[p];
+        for (size_t e = offsets[p]; e < offsets[p + 1]; ++e) {
+            const Entry& entry = entries[e];
+            auto row = table[entry.row];
+            size_t s = Hash(entry.key) & (capacity - 1);
+            while (slots[s] != kNone && !(out[slots[s] * width] == entry.key)) {
+                s = (s + 1) & (capacity - 1);
+            }
+            if (slots[s] == kNone) {
+                slots[s] = static_cast<uint32_t>(out.size() / width);
+                out.push_back(entry.key);
+                for (const auto& agg : aggregates) {
+                    out.push_back(agg.op == Aggregate::kCount ? T(1) : row[agg.column]);
+                }
+                continue;
+            }
+            T* acc = &out[slots[s] * width + 1];
+            for (size_t a = 0; a < aggregates.size(); ++a) {
+                switch (aggregates[a].op) {
+                    case Aggregate::kCount: acc[a] += T(1); break;
+                    case Aggregate::kSum: acc[a] += row[aggregates[a].column]; break;
+                    case Aggregate::kMin: acc[a] = std::min(acc[a], row[aggregates[a].column]); break;
+                    case Aggregate::kMax: acc[a] = std::max(acc[a], row[aggregates[a].column]); break;
+                }
+            }
+        }
+    });
+
+    std::vector<size_t> starts(groups.size() + 1, 0);
+    for (size_t p = 0; p < groups.size(); ++p) {
+        starts[p + 1] = starts[p] + groups[p].size() / width;
+    }
+    Table<T> result(starts.back(), width);
+    ParallelFor(groups.size(), [&](size_t p) {
+        // A freshly built Table has stride == columns, so its rows are back to back.
+        if (!groups[p].empty()) {
+            std::copy(groups[p].begin(), groups[p].end(), result[starts[p]].data());
+        }
+    });
+    return result;
+}
+
+template<typename T>
+Table<T> QueryEngine<T>::Join(const Table<T>& build, const size_t build_key, const Table<T>& probe, const size_t probe_key) const {
+    const unsigned bits = RadixBits(build.size().first);
+    std::vector<Entry> build_entries, probe_entries;
+    std::vector<size_t> build_offsets, probe_offsets;
+    Partition(build, build_key, bits, build_entries, build_offsets);
+    Partition(probe, probe_key, bits, probe_entries, probe_offsets);
+
+    // matches[p] holds (probe row, build row) pairs found in partition p.
+    std::vector<std::vector<std::pair<size_t, size_t>>> matches(build_offsets.size() - 1);
+    ParallelFor(matches.size(), [&](size_t p) {
+        const size_t base = build_offsets[p];
+        const size_t capacity = TableCapacity(build_offsets[p + 1] - base);
+        std::vector<uint32_t> heads(capacity, kNone);
+        std::vector<uint32_t> next(build_offsets[p + 1] - base);
+        for (size_t e = base; e < build_offsets[p + 1]; ++e) {
+            size_t s = Hash(build_entries[e].key) & (capacity - 1);
+            next[e - base] = heads[s];
+            heads[s] = static_cast<uint32_t>(e - base);
+        }
+        for (size_t e = probe_offsets[p]; e < probe_offsets[p + 1]; ++e) {
+            const Entry& entry = probe_entries[e];
+            for (uint32_t j = heads[Hash(entry.key) & (capacity - 1)]; j != kNone; j = next[j]) {
+                if (build_entries[base + j].key == entry.key) {
+                    matches[p].emplace_back(entry.row, build_entries[base + j].row);
+                }
+            }
+        }
+    });
+
+    const size_t probe_width = probe.size().second;
+    const size_t build_width = build.size().second;
+    std::vector<size_t> starts(matches.size() + 1, 0);
+    for (size_t p = 0; p < matches.size(); ++p) {
+        starts[p + 1] = starts[p] + matches[p].size();
+    }
+    Table<T> result(starts.back(), probe_width + build_width);
+    ParallelFor(matches.size(), [&](size_t p) {
+        size_t r = starts[p];
+        for (const auto& [probe_row, build_row] : matches[p]) {
+            auto out = result[r++];
+            std::copy(probe[probe_row].begin(), probe[probe_row].end(), out.begin());
+            std::copy(build[build_row].begin(), build[build_row].end(), out.begin() + probe_width);
+        }
+    });
+    return result;
+}
+
+// On-disk Table layout, in native byte order: a 64-byte header, zero
+// padding, then rows * columns cells row-major from data_offset, which is
+// page-aligned so the cells can be mapped directly.
+struct TableFileHeader {
+    char magic[8];
+    uint32_t type_tag;  // TableTypeTag<T>()
+    uint32_t cell_size;
+    uint64_t rows;
+    uint64_t columns;
+    uint64_t data_offset;
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(TableFileHeader) == 64, "header layout is part of the file format");
+
+constexpr char kTableFileMagic[8] = {'T', 'A', 'B', 'L', 'E', '0', '1', '\0'};
+constexpr size_t kTableFileDataOffset = 4096;
+
+// Kind (0 unsigned, 1 signed, 2 floating point, 3 bool) in bits 8+, size in
+// bytes below. bool has a kind of its own: a uint8_t file may hold bytes other
+// than 0 and 1, which are not valid bools.
+template<typename T>
+constexpr uint32_t TableTypeTag() {
+    static_assert(std::is_arithmetic_v<T>, "table files hold arithmetic cells");
+    const uint32_t kind = std::is_same_v<T, bool> ? 3u : std::is_floating_point_v<T> ? 2u : std::is_signed_v<T> ? 1u : 0u;
+    return kind << 8 | static_cast<uint32_t>(sizeof(T));
+}
+
+[[noreturn]] inline void FailTableFile(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Writes a table file row by row without holding the table in memory. Rows
+// go to path + ".tmp", whose header stays zeroed until Finish() has written
+// and synced every row; Finish() then renames it over path. A table already
+// at path, and any MappedTable of it, is untouched until that rename, and a
+// builder destroyed without Finish() removes its temporary file.
+template<typename T>
+class TableFileBuilder {
+private:
+    static constexpr size_t kBufferBytes = 1 << 20;
+
+    std::string path;
+    std::string tmp_path;
+    int fd = -1;
+    size_t columns;
+    uint64_t rows = 0;
+    // A plain array rather than std::vector<T>, which has no data() for bool.
+    std::unique_ptr<T[]> buffer;
+    size_t buffer_capacity;  // cells
+    size_t buffered = 0;
+
+    void WriteAll(const char* data, size_t size) {
+        while (size) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                FailTableFile("write " + tmp_path);
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void Flush() {
+        WriteAll(reinterpret_cast<const char*>(buffer.get()), buffered * sizeof(T));
+        buffered = 0;
+    }
+
+public:
+    TableFileBuilder(const std::string& path, const size_t columns):
+        path(path),
+        tmp_path(path + ".tmp"),
+        columns(columns),
+        buffer_capacity(std::max<size_t>(columns, kBufferBytes / sizeof(T))) {
+        fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            FailTableFile("open " + tmp_path);
+        }
+        std::vector<char> zeros(kTableFileDataOffset, '\0');
+        try {
+            WriteAll(zeros.data(), zeros.size());
+        } catch (...) {
+            Abandon();
+            throw;
+        }
+        buffer.reset(new T[buffer_capacity]);
+    }
+
+    TableFileBuilder(const TableFileBuilder&) = delete;
+
+    TableFileBuilder& operator=(const TableFileBuilder&) = delete;
+
+    ~TableFileBuilder() {
+        if (fd >= 0) {
+            Abandon();
+        }
+    }
+
+    // Appends one row of `columns` cells.
+    void AppendRow(const T* cells) {
+        if (fd < 0) {
+            throw std::logic_error("table file already finished");
+        }
+        if (buffered + columns > buffer_capacity) {
+            Flush();
+        }
+        std::copy(cells, cells + columns, buffer.get() + buffered);
+        buffered += columns;
+        ++rows;
+    }
+
+    void AppendRow(typename Table<T>::ConstRow row) {
+        AppendRow(row.data());
+    }
+
+    // Flushes the rows, syncs them, writes the header, then renames the
+    // file into place.
+    void Finish() {
+        if (fd < 0) {
+            throw std::logic_error("table file already finished");
+        }
+        Flush();
+        if (::fsync(fd) != 0) {
+            FailTableFile("fsync " + tmp_path);
+        }
+        TableFileHeader header{};
+        std::memcpy(header.magic, kTableFileMagic, sizeof(kTableFileMagic));
+        header.type_tag = TableTypeTag<T>();
+        header.cell_size = sizeof(T);
+        header.rows = rows;
+        header.columns = columns;
+        header.data_offset = kTableFileDataOffset;
+        if (::pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || ::fsync(fd) != 0) {
+            FailTableFile("write header " + tmp_path);
+        }
+        ::close(fd);
+        fd = -1;
+        if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            const int error = errno;
+            ::unlink(tmp_path.c_str());
+            errno = error;
+            FailTableFile("rename " + tmp_path);
+        }
+        SyncDirectory();
+    }
+
+private:
+    void Abandon() {
+        ::close(fd);
+        fd = -1;
+        ::unlink(tmp_path.c_str());
+    }
+
+    // Makes the rename itself durable.
+    void SyncDirectory() const {
+        std::string dir = std::filesystem::path(path).parent_path().string();
+        int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (dir_fd >= 0) {
+            ::fsync(dir_fd);
+            ::close(dir_fd);
+        }
+    }
+};
+
+enum class MappingMode { kReadOnly, kCopyOnWrite };
+
+// A table file mapped into memory. Opening validates the header and maps the
+// file; rows are paged in by the kernel on first touch, so opening costs the
+// same for any table size. kReadOnly mappings hand out only ConstRow;
+// kCopyOnWrite mappings also accept writes, which stay private to the process
+// and never reach the file.
+template<typename T, MappingMode Mode = MappingMode::kReadOnly>
+class MappedTable {
+public:
+    using Row = std::conditional_t<Mode == MappingMode::kCopyOnWrite, typename Table<T>::Row, typename Table<T>::ConstRow>;
+
+private:
+    char* base = nullptr;
+    size_t mapped_size = 0;
+    size_t columns = 0, rows = 0;
+    T* cells = nullptr;
+
+    void Advise(const size_t row_begin, const size_t row_end, const int advice) const {
+        if (row_begin >= row_end) {
+            return;
+        }
+        // madvise wants a page-aligned start.
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t from = kTableFileDataOffset + row_begin * columns * sizeof(T);
+        size_t to = kTableFileDataOffset + row_end * columns * sizeof(T);
+        from -= from % page;
+        ::madvise(base + from, to - from, advice);
+    }
+
+public:
+    explicit MappedTable(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);  // MAP_PRIVATE writes never need a writable fd
+        if (fd < 0) {
+            FailTableFile("open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            FailTableFile("stat " + path);
+        }
+        mapped_size = static_cast<size_t>(st.st_size);
+        if (mapped_size < kTableFileDataOffset) {
+            ::close(fd);
+            throw std::runtime_error("corrupt table file " + path);
+        }
+        void* addr = Mode == MappingMode::kReadOnly
+            ? ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0)
+            : ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            FailTableFile("mmap " + path);
+        }
+        base = static_cast<char*>(addr);
+        TableFileHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, kTableFileMagic, sizeof(kTableFileMagic)) != 0 ||
+            header.data_offset != kTableFileDataOffset ||
+            (header.columns && header.rows > (mapped_size - kTableFileDataOffset) / sizeof(T) / header.columns)) {
+            ::munmap(base, mapped_size);
+            throw std::runtime_error("corrupt table file " + path);
+        }
+        if (header.type_tag != TableTypeTag<T>() || header.cell_size != sizeof(T)) {
+            ::munmap(base, mapped_size);
+            throw std::runtime_error("cell type mismatch in table file " + path);
+        }
+        rows = static_cast<size_t>(header.rows);
+        columns = static_cast<size_t>(header.columns);
+        cells = reinterpret_cast<T*>(base + kTableFileDataOffset);
+    }
+
+    MappedTable(const MappedTable&) = delete;
+
+    MappedTable& operator=(const MappedTable&) = delete;
+
+    ~MappedTable() {
+        ::munmap(base, mapped_size);
+    }
+
+    typename Table<T>::ConstRow operator[](const size_t r) const {
+        return typename Table<T>::ConstRow(cells + r * columns, columns);
+    }
+
+    Row operator[](const size_t r) {
+        return Row(cells + r * columns, columns);
+    }
+
+    std::pair<size_t, size_t> size() const {
+        return std::make_pair(rows, columns);
+    }
+
+    // Access-pattern hints for the whole table: aggressive read-ahead for
+    // full scans, none for point lookups.
+    void AdviseSequential() const {
+        Advise(0, rows, MADV_SEQUENTIAL);
+    }
+
+    void AdviseRandom() const {
+        Advise(0, rows, MADV_RANDOM);
+    }
+
+    // Starts reading rows [row_begin, row_end) in the background.
+    void Prefetch(const size_t row_begin, const size_t row_end) const {
+        Advise(row_begin, std::min(row_end, rows), MADV_WILLNEED);
+    }
+
+    Table<T> ToTable() const {
+        Table<T> table(rows, columns);
+        if (rows && columns) {
+            std::copy(cells, cells + rows * columns, table[0].data());
+        }
+        return table;
+    }
+};
+
+// A QueryEngine key whose comparison throws for one poisoned value.
+struct PoisonKey {
+    static constexpr int64_t kPoison = 7;
+    int64_t value = 0;
+
+    PoisonKey() = default;
+    PoisonKey(const int64_t value): value(value) {}
+
+    bool operator==(const PoisonKey& other) const {
+        if (value == kPoison) {
+            throw std::runtime_error("poisoned key");
+        }
+        return value == other.value;
+    }
+
+    bool operator<(const PoisonKey& other) const {
+        return value < other.value;
+    }
+
+    PoisonKey& operator+=(const PoisonKey& other) {
+        value += other.value;
+        return *this;
+    }
+};
+
+namespace std {
+template<>
+struct hash<PoisonKey> {
+    size_t operator()(const PoisonKey& key) const {
+        return hash<int64_t>()(key.value);
+    }
+};
+}  // namespace std
+
 int main() {
     // 1. Создаём таблицу int 3x2
     Table<int> table(3, 2);
@@ -86,5 +1179,581 @@ int main() {
     sz = table.size();
     std::cout << "Текущий размер: " << sz.first << " x " << sz.second << '\n';
 
+    // 9. Изменение формы в пределах ёмкости не перевыделяет буфер
+    assert(table[0][0] == 10 && table[2][1] == 60 && table[1][2] == 0 && table[3][0] == 0);
+    table.reserve(8, 4);
+    [[maybe_unused]] const int* buffer = table[0].data();
+    assert(table[2][1] == 60 && table[3][2] == 999);
+    table.resize(2, 1);
+    table.resize(8, 4);
+    assert(table[0].data() == buffer && table.capacity() == std::make_pair(size_t{8}, size_t{4}));
+    assert(table[0][0] == 10 && table[1][0] == 30);
+    for (size_t i = 0; i < 8; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            assert((i < 2 && j < 1) || table[i][j] == 0);  // ячейки вне старой формы обнулены
+        }
+    }
+    table.resize(9, 4);
+    assert(table[0].data() != buffer && table.capacity().first == 16 && table[1][0] == 30);
+    int row_sum = 0;
+    for (int x : const_table[1]) {
+        row_sum += x;
+    }
+    assert(row_sum == 30 && const_table[1].size() == 4);
+    std::cout << "✅ resize внутри ёмкости сохраняет буфер, новые ячейки — T()\n";
+
+    // 9a. Table<bool> хранит настоящие bool, копия не делит буфер
+    {
+        Table<bool> flags(2, 2);
+        flags[0][1] = true;
+        flags.resize(3, 3);
+        assert(flags[0][1] && !flags[0][0] && !flags[2][2]);
+        bool* cell = flags[0].data();
+        cell[2] = true;
+        Table<bool> copy = flags;
+        copy[0][1] = false;
+        assert(flags[0][1] && flags[0][2] && !copy[0][1] && copy[0][2] && copy.size() == flags.size());
+        flags = copy;
+        assert(!flags[0][1] && flags[0].data() != copy[0].data());
+        Table<bool> moved = std::move(flags);
+        assert(moved[0][2] && flags.size() == std::make_pair(size_t{0}, size_t{0}));
+        assert(flags.capacity() == std::make_pair(size_t{0}, size_t{0}));
+        flags.resize(3, 3);  // перемещённая таблица снова пригодна
+        flags[2][2] = true;
+        copy = std::move(moved);
+        assert(copy[0][2] && moved.size().first == 0 && flags[2][2] && !flags[0][2]);
+        std::cout << "✅ Table<bool>: resize, data(), копирование и перемещение\n";
+    }
+
+    // 10. Бенчмарк: 10^6 x 8, вектор векторов против одного буфера
+    const size_t kRows = 1000000, kColumns = 8;
+    using clock = std::chrono::steady_clock;
+    std::cout << "\n⏱  Таблица " << kRows << " x " << kColumns << " int64_t:\n";
+    auto start = clock::now();
+    std::vector<std::vector<int64_t>> nested(kRows, std::vector<int64_t>(kColumns));
+    std::chrono::duration<double> nested_build = clock::now() - start;
+    start = clock::now();
+    Table<int64_t> flat(kRows, kColumns);
+    std::chrono::duration<double> flat_build = clock::now() - start;
+    for (size_t i = 0; i < kRows; ++i) {
+        for (size_t j = 0; j < kColumns; ++j) {
+            nested[i][j] = flat[i][j] = static_cast<int64_t>(i * 31 + j);
+        }
+    }
+    auto time_scan = [&](auto&& rows) {
+        auto begin = clock::now();
+        int64_t total = 0;
+        for (int pass = 0; pass < 10; ++pass) {
+            for (size_t i = 0; i < kRows; ++i) {
+                for (int64_t x : rows(i)) {
+                    total += x;
+                }
+            }
+        }
+        std::chrono::duration<double> dur = clock::now() - begin;
+        return std::make_pair(dur.count(), total);
+    };
+    auto nested_scan = time_scan([&](size_t i) -> const std::vector<int64_t>& { return nested[i]; });
+    auto flat_scan = time_scan([&](size_t i) { return const_cast<const Table<int64_t>&>(flat)[i]; });
+    assert(nested_scan.second == flat_scan.second);
+    std::cout << std::fixed << "   создание: vector<vector> " << nested_build.count() << " с, Table " << flat_build.count() << " с\n"
+              << "   10 полных проходов: vector<vector> " << nested_scan.first << " с, Table " << flat_scan.first
+              << " с, ускорение " << nested_scan.first / flat_scan.first << "x\n";
+
+    // 11. Колоночное хранение: столбцы выровнены по 64 байтам, агрегаты совпадают со скалярными
+    for (size_t n : {size_t{0}, size_t{1}, size_t{15}, size_t{16}, size_t{17}, size_t{1000}}) {
+        Table<int> rows_table(n, 3);
+        std::mt19937 rng(static_cast<unsigned>(n));
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                rows_table[i][j] = static_cast<int>(rng() % 2001) - 1000;
+            }
+        }
+        ColumnarTable<int> columnar(rows_table);
+        int sum = 0, filtered = 0;
+        size_t positive = 0;
+        for (size_t i = 0; i < n; ++i) {
+            assert(reinterpret_cast<uintptr_t>(columnar.Column(i % 3)) % 64 == 0);
+            sum += rows_table[i][1];
+            positive += rows_table[i][2] > 0;
+            if (rows_table[i][0] > -100 && rows_table[i][0] < 100) {
+                filtered += rows_table[i][2];
+            }
+        }
+        assert(columnar.Sum(1) == sum);
+        assert(columnar.CountIf(2, [](auto x) { return x > 0; }) == positive);
+        assert(columnar.SumIf(2, 0, [](auto x) { return (x > -100) & (x < 100); }) == filtered);
+        if (n == 0) {
+            [[maybe_unused]] bool thrown = false;
+            try {
+                columnar.Min(0);
+            } catch (const std::out_of_range&) {
+                thrown = true;
+            }
+            assert(thrown);
+        } else {
+            int lo = rows_table[0][0], hi = rows_table[0][0];
+            for (size_t i = 0; i < n; ++i) {
+                lo = std::min(lo, rows_table[i][0]);
+                hi = std::max(hi, rows_table[i][0]);
+            }
+            assert(columnar.Min(0) == lo && columnar.Max(0) == hi);
+        }
+        Table<int> back = columnar.ToTable();
+        for (size_t i = 0; i < n; ++i) {
+            assert(back[i][0] == rows_table[i][0] && back[i][2] == rows_table[i][2]);
+        }
+    }
+    ColumnarTable<signed char> bytes(100000, 1);
+    std::fill_n(bytes.Column(0), 100000, 1);
+    assert(bytes.CountIf(0, [](auto x) { return x == 1; }) == 100000);  // счётчики по 8 бит не переполняются
+    ColumnarTable<double> doubles(33, 1);
+    for (size_t i = 0; i < 33; ++i) {
+        doubles(i, 0) = 0.5 * static_cast<double>(i);
+    }
+    assert(doubles.Sum(0) == 264.0 && doubles.Max(0) == 16.0 && doubles.CountIf(0, [](auto x) { return x >= 8.0; }) == 17);
+    std::cout << "✅ ColumnarTable: Sum/Min/Max/CountIf/SumIf совпадают со скалярными для int, signed char, double\n";
+
+    // 12. Бенчмарк: запрос по 2 столбцам из 30
+    const size_t kWideRows = 1000000, kWideColumns = 30;
+    std::cout << "\n⏱  SUM(c3) WHERE c7 < 100, таблица " << kWideRows << " x " << kWideColumns << " int32_t:\n";
+    Table<int32_t> wide(kWideRows, kWideColumns);
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < kWideRows; ++i) {
+        for (size_t j = 0; j < kWideColumns; ++j) {
+            wide[i][j] = static_cast<int32_t>(rng() % 1000);
+        }
+    }
+    ColumnarTable<int32_t> wide_columnar(wide);
+    auto time_query = [&](const char* name, auto&& query) {
+        auto begin = clock::now();
+        int64_t total = 0;
+        for (int pass = 0; pass < 10; ++pass) {
+            total += query();
+        }
+        std::chrono::duration<double> dur = clock::now() - begin;
+        std::cout << "   " << name << ": " << std::fixed << dur.count() << " с, сумма " << total << "\n";
+        return total;
+    };
+    [[maybe_unused]] const int64_t by_rows = time_query("Table, построчно          ", [&] {
+        int32_t total = 0;
+        for (size_t i = 0; i < kWideRows; ++i) {
+            if (wide[i][7] < 100) {
+                total += wide[i][3];
+            }
+        }
+        return total;
+    });
+    [[maybe_unused]] const int64_t by_columns = time_query("ColumnarTable, скалярно   ", [&] {
+        const int32_t* values = wide_columnar.Column(3);
+        const int32_t* keys = wide_columnar.Column(7);
+        int32_t total = 0;
+        for (size_t i = 0; i < kWideRows; ++i) {
+            if (keys[i] < 100) {
+                total += values[i];
+            }
+        }
+        return total;
+    });
+    [[maybe_unused]] const int64_t by_simd = time_query("ColumnarTable::SumIf      ", [&] {
+        return wide_columnar.SumIf(3, 7, [](auto x) { return x < 100; });
+    });
+    assert(by_rows == by_columns && by_columns == by_simd);
+
+    // 13. Группировка и соединение сверяются с std::map и вложенными циклами
+    using Engine = QueryEngine<int64_t>;
+    [[maybe_unused]] auto sorted_rows = [](const Table<int64_t>& t) {
+        std::vector<std::vector<int64_t>> out;
+        for (size_t i = 0; i < t.size().first; ++i) {
+            out.emplace_back(t[i].begin(), t[i].end());
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+    for (size_t n : {size_t{0}, size_t{1}, size_t{100}, size_t{50000}}) {
+        Table<int64_t> facts(n, 3);
+        for (size_t i = 0; i < n; ++i) {
+            facts[i][0] = static_cast<int64_t>(rng() % 1000);
+            facts[i][1] = static_cast<int64_t>(rng() % 100) - 50;
+            facts[i][2] = static_cast<int64_t>(i);
+        }
+        std::map<int64_t, std::vector<int64_t>> expected;
+        for (size_t i = 0; i < n; ++i) {
+            auto [it, fresh] = expected.try_emplace(facts[i][0], std::vector<int64_t>{0, 0, facts[i][1], facts[i][1]});
+            auto& agg = it->second;
+            agg[0] += 1;
+            agg[1] += facts[i][1];
+            agg[2] = std::min(agg[2], facts[i][1]);
+            agg[3] = std::max(agg[3], facts[i][1]);
+        }
+        std::vector<std::vector<int64_t>> expected_rows;
+        for (const auto& [key, agg] : expected) {
+            expected_rows.push_back({key, agg[0], agg[1], agg[2], agg[3]});
+        }
+        Table<int64_t> dims(n / 10, 2);
+        for (size_t i = 0; i < dims.size().first; ++i) {
+            dims[i][0] = static_cast<int64_t>(rng() % 1000);  // с повторами: одной строке может соответствовать несколько
+            dims[i][1] = static_cast<int64_t>(i);
+        }
+        std::vector<std::vector<int64_t>> expected_join;
+        std::unordered_multimap<int64_t, size_t> dim_index;
+        for (size_t j = 0; j < dims.size().first; ++j) {
+            dim_index.emplace(dims[j][0], j);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            auto [from, to] = dim_index.equal_range(facts[i][0]);
+            for (; from != to; ++from) {
+                expected_join.push_back({facts[i][0], facts[i][1], facts[i][2], dims[from->second][0], dims[from->second][1]});
+            }
+        }
+        std::sort(expected_join.begin(), expected_join.end());
+        for (size_t threads : {size_t{1}, size_t{4}}) {
+            Engine engine(threads);
+            Table<int64_t> grouped = engine.GroupBy(facts, 0, {{Engine::Aggregate::kCount, 0}, {Engine::Aggregate::kSum, 1},
+                                                               {Engine::Aggregate::kMin, 1}, {Engine::Aggregate::kMax, 1}});
+            assert(grouped.size().second == 5 && sorted_rows(grouped) == expected_rows);
+            Table<int64_t> joined = engine.Join(dims, 0, facts, 0);
+            assert(joined.size().second == 5 && sorted_rows(joined) == expected_join);
+        }
+    }
+    {
+        // Исключение из рабочего потока доходит до вызывающего, а не вызывает std::terminate
+        Table<PoisonKey> poisoned(100000, 1);
+        for (size_t i = 0; i < poisoned.size().first; ++i) {
+            poisoned[i][0] = static_cast<int64_t>(i % 1000);
+        }
+        for (size_t threads : {size_t{1}, size_t{4}}) {
+            [[maybe_unused]] bool thrown = false;
+            try {
+                QueryEngine<PoisonKey>(threads).GroupBy(poisoned, 0, {{QueryEngine<PoisonKey>::Aggregate::kCount, 0}});
+            } catch (const std::runtime_error& e) {
+                thrown = std::string(e.what()) == "poisoned key";
+            }
+            assert(thrown);
+        }
+    }
+    std::cout << "✅ QueryEngine: GroupBy (COUNT/SUM/MIN/MAX) и Join совпадают с эталоном на 1 и 4 потоках, исключения передаются вызывающему\n";
+
+    // 14. Бенчмарк на 10^7 строк: радиксное разбиение против одной хэш-таблицы
+    const size_t kFactRows = 10000000, kDimRows = 1000000;
+    const size_t kThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\n⏱  " << kFactRows << " строк, потоков: " << kThreads << "\n";
+    {
+        Table<int64_t> facts(kFactRows, 2);
+        for (size_t i = 0; i < kFactRows; ++i) {
+            facts[i][0] = static_cast<int64_t>(rng() % (2 * kDimRows));
+            facts[i][1] = static_cast<int64_t>(rng() % 1000);
+        }
+        Engine engine(kThreads);
+        auto begin = clock::now();
+        Table<int64_t> grouped = engine.GroupBy(facts, 0, {{Engine::Aggregate::kCount, 0}, {Engine::Aggregate::kSum, 1}});
+        std::chrono::duration<double> engine_group = clock::now() - begin;
+        begin = clock::now();
+        std::unordered_map<int64_t, std::pair<int64_t, int64_t>> naive_groups;
+        for (size_t i = 0; i < kFactRows; ++i) {
+            auto& agg = naive_groups[facts[i][0]];
+            ++agg.first;
+            agg.second += facts[i][1];
+        }
+        std::chrono::duration<double> naive_group = clock::now() - begin;
+        int64_t engine_total = 0, naive_total = 0;
+        for (size_t i = 0; i < grouped.size().first; ++i) {
+            engine_total += grouped[i][1] * 1000003 + grouped[i][2];
+        }
+        for (const auto& [key, agg] : naive_groups) {
+            naive_total += agg.first * 1000003 + agg.second;
+        }
+        assert(grouped.size().first == naive_groups.size() && engine_total == naive_total);
+        std::cout << std::fixed << "   GROUP BY (" << grouped.size().first << " групп): std::unordered_map " << naive_group.count()
+                  << " с, QueryEngine " << engine_group.count() << " с\n";
+
+        Table<int64_t> dims(kDimRows, 2);
+        std::vector<int64_t> dim_keys(kDimRows);
+        for (size_t j = 0; j < kDimRows; ++j) {
+            dim_keys[j] = static_cast<int64_t>(j);
+        }
+        std::shuffle(dim_keys.begin(), dim_keys.end(), rng);
+        for (size_t j = 0; j < kDimRows; ++j) {
+            dims[j][0] = dim_keys[j];
+            dims[j][1] = static_cast<int64_t>(j);
+        }
+        begin = clock::now();
+        Table<int64_t> joined = engine.Join(dims, 0, facts, 0);
+        std::chrono::duration<double> engine_join = clock::now() - begin;
+        begin = clock::now();
+        std::unordered_multimap<int64_t, size_t> naive_index;
+        for (size_t j = 0; j < kDimRows; ++j) {
+            naive_index.emplace(dims[j][0], j);
+        }
+        Table<int64_t> naive_joined(0, 4);
+        std::vector<std::pair<size_t, size_t>> naive_pairs;
+        for (size_t i = 0; i < kFactRows; ++i) {
+            auto [from, to] = naive_index.equal_range(facts[i][0]);
+            for (; from != to; ++from) {
+                naive_pairs.emplace_back(i, from->second);
+            }
+        }
+        naive_joined.resize(naive_pairs.size(), 4);
+        for (size_t r = 0; r < naive_pairs.size(); ++r) {
+            std::copy(facts[naive_pairs[r].first].begin(), facts[naive_pairs[r].first].end(), naive_joined[r].begin());
+            std::copy(dims[naive_pairs[r].second].begin(), dims[naive_pairs[r].second].end(), naive_joined[r].begin() + 2);
+        }
+        std::chrono::duration<double> naive_join = clock::now() - begin;
+        assert(joined.size() == naive_joined.size());
+        std::cout << "   JOIN " << kDimRows << " x " << kFactRows << " (" << joined.size().first << " пар): std::unordered_multimap "
+                  << naive_join.count() << " с, QueryEngine " << engine_join.count() << " с\n";
+    }
+
+    // 15. Файл таблицы: потоковая запись, отображение в память, проверка заголовка
+    namespace fs = std::filesystem;
+    const std::string table_dir = (fs::temp_directory_path() / "table_file_test").string();
+    fs::remove_all(table_dir);
+    fs::create_directories(table_dir);
+    const std::string small_path = table_dir + "/small.tbl";
+    {
+        TableFileBuilder<int64_t> builder(small_path, 3);
+        for (int64_t i = 0; i < 1000; ++i) {
+            const int64_t cells[3] = {i, i * i, -i};
+            builder.AppendRow(cells);
+        }
+        builder.Finish();
+    }
+    {
+        MappedTable<int64_t> mapped(small_path);
+        assert(mapped.size() == std::make_pair(size_t{1000}, size_t{3}));
+        [[maybe_unused]] const MappedTable<int64_t>& const_mapped = mapped;
+        assert(const_mapped[999][1] == 999 * 999 && const_mapped[7][2] == -7);
+        assert(reinterpret_cast<uintptr_t>(const_mapped[0].data()) % 4096 == 0);
+        static_assert(std::is_same_v<decltype(mapped[0]), Table<int64_t>::ConstRow>, "read-only rows are not writable");
+        assert(mapped[0].data() == const_mapped[0].data());
+        Table<int64_t> loaded = mapped.ToTable();
+        assert(loaded[500][1] == 250000);
+    }
+    {
+        MappedTable<int64_t, MappingMode::kCopyOnWrite> private_copy(small_path);
+        static_assert(std::is_same_v<decltype(private_copy[0]), Table<int64_t>::Row>, "copy-on-write rows are writable");
+        private_copy[5][0] = 42;
+        assert(private_copy[5][0] == 42);
+        MappedTable<int64_t> reopened(small_path);
+        assert(reopened[5][0] == 5);  // запись не дошла до файла
+    }
+    {
+        // Пересборка файла под живым отображением: старое видит прежние данные до конца
+        MappedTable<int64_t> old_mapping(small_path);
+        {
+            TableFileBuilder<int64_t> abandoned(small_path, 3);
+            const int64_t cells[3] = {-1, -1, -1};
+            abandoned.AppendRow(cells);
+            MappedTable<int64_t> still_old(small_path);
+            assert(fs::exists(small_path + ".tmp") && still_old.size().first == 1000);
+        }
+        assert(!fs::exists(small_path + ".tmp") && old_mapping[999][1] == 999 * 999);
+        TableFileBuilder<int64_t> rebuild(small_path, 3);
+        for (int64_t i = 0; i < 1000; ++i) {
+            const int64_t cells[3] = {i, i * i, -i};
+            rebuild.AppendRow(cells);
+            assert(old_mapping[i][2] == -i);
+        }
+        rebuild.Finish();
+        assert(!fs::exists(small_path + ".tmp") && old_mapping[999][2] == -999);
+        MappedTable<int64_t> rebuilt(small_path);
+        assert(rebuilt[999][1] == 999 * 999);
+    }
+    auto expect_runtime_error = [](auto&& open) {
+        [[maybe_unused]] bool thrown = false;
+        try {
+            open();
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    };
+    expect_runtime_error([&] { MappedTable<int32_t> wrong_type(small_path); });
+    {
+        // bool и uint8_t одного размера, но разных видов
+        static_assert(TableTypeTag<bool>() != TableTypeTag<uint8_t>() && TableTypeTag<bool>() != TableTypeTag<int8_t>(), "bool has its own kind");
+        TableFileBuilder<uint8_t> bytes(table_dir + "/bytes.tbl", 2);
+        const uint8_t byte_cells[2] = {0, 200};
+        bytes.AppendRow(byte_cells);
+        bytes.Finish();
+        expect_runtime_error([&] { MappedTable<bool> not_bool(table_dir + "/bytes.tbl"); });
+        Table<bool> flags(3, 2);
+        flags[1][0] = flags[2][1] = true;
+        TableFileBuilder<bool> bools(table_dir + "/flags.tbl", 2);
+        for (size_t r = 0; r < 3; ++r) {
+            bools.AppendRow(flags[r]);
+        }
+        bools.Finish();
+        MappedTable<bool> mapped_flags(table_dir + "/flags.tbl");
+        assert(mapped_flags[1][0] && mapped_flags[2][1] && !mapped_flags[0][0] && !mapped_flags[2][0]);
+        expect_runtime_error([&] { MappedTable<uint8_t> not_bytes(table_dir + "/flags.tbl"); });
+    }
+    expect_runtime_error([&] { MappedTable<int64_t> missing(table_dir + "/missing.tbl"); });
+    fs::resize_file(small_path, kTableFileDataOffset + 100 * 3 * sizeof(int64_t));
+    expect_runtime_error([&] { MappedTable<int64_t> truncated(small_path); });
+    {
+        TableFileBuilder<double> unfinished(table_dir + "/unfinished.tbl", 2);
+        const double cells[2] = {1.0, 2.0};
+        unfinished.AppendRow(cells);
+        expect_runtime_error([&] { MappedTable<double> partial(table_dir + "/unfinished.tbl.tmp"); });
+    }
+    // деструктор без Finish() ничего не публикует и убирает временный файл
+    expect_runtime_error([&] { MappedTable<double> abandoned(table_dir + "/unfinished.tbl"); });
+    assert(!fs::exists(table_dir + "/unfinished.tbl.tmp"));
+    {
+        TableFileBuilder<float> empty_builder(table_dir + "/empty.tbl", 4);
+        empty_builder.Finish();
+    }
+    MappedTable<float> empty_mapped(table_dir + "/empty.tbl");
+    assert(empty_mapped.size() == std::make_pair(size_t{0}, size_t{4}));
+    std::cout << "✅ TableFileBuilder/MappedTable: чтение, копирование при записи, битые и недописанные файлы, пересборка под отображением\n";
+
+    // 16. Бенчмарк: открытие файла против полной загрузки
+    {
+        const size_t kFileRows = 4000000, kFileColumns = 8;
+        const std::string big_path = table_dir + "/big.tbl";
+        auto begin = clock::now();
+        {
+            TableFileBuilder<int64_t> builder(big_path, kFileColumns);
+            int64_t cells[kFileColumns];
+            for (size_t i = 0; i < kFileRows; ++i) {
+                for (size_t j = 0; j < kFileColumns; ++j) {
+                    cells[j] = static_cast<int64_t>(i + j);
+                }
+                builder.AppendRow(cells);
+            }
+            builder.Finish();
+        }
+        std::chrono::duration<double> build = clock::now() - begin;
+        // Drops the file from the page cache, so every run starts cold.
+        auto evict = [&] {
+            int fd = ::open(big_path.c_str(), O_RDONLY);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        };
+        auto sum_column = [](const auto& table, size_t rows) {
+            int64_t total = 0;
+            for (size_t i = 0; i < rows; ++i) {
+                total += table[i][3];
+            }
+            return total;
+        };
+        const double file_mb = static_cast<double>(fs::file_size(big_path)) / (1 << 20);
+        std::cout << "\n⏱  Файл " << kFileRows << " x " << kFileColumns << " int64_t (" << std::fixed << file_mb << " МБ):\n"
+                  << "   потоковая запись: " << build.count() << " с\n";
+
+        evict();
+        begin = clock::now();
+        Table<int64_t> in_memory(kFileRows, kFileColumns);
+        {
+            std::ifstream in(big_path, std::ios::binary);
+            in.seekg(kTableFileDataOffset);
+            in.read(reinterpret_cast<char*>(in_memory[0].data()), kFileRows * kFileColumns * sizeof(int64_t));
+        }
+        std::chrono::duration<double> load = clock::now() - begin;
+        [[maybe_unused]] const int64_t expected = sum_column(in_memory, kFileRows);
+
+        evict();
+        begin = clock::now();
+        const MappedTable<int64_t> mapped(big_path);
+        std::chrono::duration<double> open = clock::now() - begin;
+        mapped.AdviseSequential();
+        begin = clock::now();
+        const int64_t cold_total = sum_column(mapped, kFileRows);
+        std::chrono::duration<double> cold_scan = clock::now() - begin;
+        begin = clock::now();
+        const int64_t warm_total = sum_column(mapped, kFileRows);
+        std::chrono::duration<double> warm_scan = clock::now() - begin;
+        assert(cold_total == expected && warm_total == expected);
+        // Суммы печатаются, чтобы с -DNDEBUG проходы не выбросил оптимизатор
+        std::cout << "   полная загрузка в Table: " << load.count() << " с\n"
+                  << "   открытие MappedTable: " << open.count() * 1000 << " мс\n"
+                  << "   проход по столбцу с MADV_SEQUENTIAL: холодный " << cold_scan.count() << " с, тёплый " << warm_scan.count()
+                  << " с (сумма " << cold_total << " / " << warm_total << ")\n";
+    }
+    fs::remove_all(table_dir);
+
+    // 17. Транспонирование блоками и обход плитками
+    auto check_transpose = [](auto sample, size_t n, size_t m) {
+        using Cell = decltype(sample);
+        Table<Cell> source(n, m);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < m; ++j) {
+                source[i][j] = static_cast<Cell>(i * 1000 + j);
+            }
+        }
+        source.reserve(n + 3, m + 5);  // шаг строки больше числа столбцов
+        Table<Cell> transposed = source.Transpose();
+        assert(transposed.size() == std::make_pair(m, n));
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < m; ++j) {
+                assert(transposed[j][i] == source[i][j]);
+            }
+        }
+        std::vector<int> visits(n * m, 0);
+        source.ForEachTile(4, 3, [&](size_t r0, size_t r1, size_t c0, size_t c1) {
+            assert(r1 - r0 <= 4 && c1 - c0 <= 3 && r0 < r1 && c0 < c1);
+            for (size_t i = r0; i < r1; ++i) {
+                for (size_t j = c0; j < c1; ++j) {
+                    ++visits[i * m + j];
+                }
+            }
+        });
+        assert(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+        for (auto [tile_rows, tile_columns] : {std::pair<size_t, size_t>{0, 3}, std::pair<size_t, size_t>{4, 0}}) {
+            [[maybe_unused]] bool rejected = false;
+            try {
+                source.ForEachTile(tile_rows, tile_columns, [](size_t, size_t, size_t, size_t) {});
+            } catch (const std::invalid_argument&) {
+                rejected = true;
+            }
+            assert(rejected);
+        }
+    };
+    for (auto [n, m] : {std::make_pair(0, 0), std::make_pair(1, 7), std::make_pair(5, 3),
+                        std::make_pair(17, 33), std::make_pair(130, 67), std::make_pair(64, 64)}) {
+        check_transpose(int32_t(), n, m);
+        check_transpose(float(), n, m);
+        check_transpose(int64_t(), n, m);
+        check_transpose(double(), n, m);
+        check_transpose(char(), n, m);
+        check_transpose(int16_t(), n, m);
+    }
+    Table<std::string> words(2, 3);
+    words[0][2] = "угол";
+    assert(words.Transpose()[2][0] == "угол" && words.Transpose().size() == std::make_pair(size_t{3}, size_t{2}));
+    std::cout << "✅ Transpose и ForEachTile: все размеры и типы, включая хвосты и std::string, нулевая плитка отклоняется\n";
+
+    // 18. Бенчмарк транспонирования
+    for (size_t n : {size_t{8192}}) {
+        Table<float> square(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                square[i][j] = static_cast<float>(i ^ j);
+            }
+        }
+        auto begin = clock::now();
+        Table<float> naive(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                naive[j][i] = square[i][j];
+            }
+        }
+        std::chrono::duration<double> naive_time = clock::now() - begin;
+        begin = clock::now();
+        Table<float> blocked = square.Transpose();
+        std::chrono::duration<double> blocked_time = clock::now() - begin;
+        for (size_t i = 0; i < n; i += 97) {
+            for (size_t j = 0; j < n; j += 89) {
+                assert(blocked[j][i] == square[i][j] && naive[j][i] == square[i][j]);
+            }
+        }
+        const double gb = 2.0 * n * n * sizeof(float) / 1e9;  // прочитано + записано
+        std::cout << "\n⏱  Транспонирование " << n << " x " << n << " float:\n" << std::fixed
+                  << "   наивный цикл: " << naive_time.count() << " с (" << gb / naive_time.count() << " ГБ/с)\n"
+                  << "   Transpose:    " << blocked_time.count() << " с (" << gb / blocked_time.count() << " ГБ/с)\n";
+    }
+
+    std::cout << "\n🎉 Все тесты пройдены!\n";
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev work-stealing deque (with the memory orderings from Lê et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models").
+// Only the owner thread may call PushBack/PopBack; any thread may call Steal.
+// Buffers replaced by a resize are kept until the deque is destroyed, since a
+// thief may still be reading from one of them.
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "slots are read racily by thieves");
+
+private:
+    struct Buffer {
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Buffer(int64_t capacity):
+            capacity(capacity),
+            mask(capacity - 1),
+            slots(new std::atomic<T>[capacity]) {}
+
+        T Get(int64_t i) const {
+            return slots[i & mask].load(std::memory_order_relaxed);
+        }
+
+        void Put(int64_t i, const T& elem) {
+            slots[i & mask].store(elem, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    alignas(64) std::atomic<Buffer*> buffer;
+    std::vector<std::unique_ptr<Buffer>> buffers;  // current one is buffers.back()
+
+    Buffer* Grow(Buffer* old, int64_t b, int64_t t);
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 64);
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+
+    WorkStealingDeque& operator = (const WorkStealingDeque&) = delete;
+
+    bool Empty() const;
+
+    size_t Size() const;  // a snapshot, exact only when no other thread is active
+
+    void PushBack(const T& elem);  // owner only
+
+    bool PopBack(T* const value);  // owner only, LIFO end
+
+    bool Steal(T* const value);  // any thread, FIFO end; false if empty or lost a race
+};
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) {
+    int64_t size = 1;
+    while (size < static_cast<int64_t>(capacity)) {
+        size <<= 1;
+    }
+    buffers.push_back(std::make_unique<Buffer>(size));
+    buffer.store(buffers.back().get(), std::memory_order_relaxed);
+}
+
+template<typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::Grow(Buffer* old, int64_t b, int64_t t) {
+    buffers.push_back(std::make_unique<Buffer>(old->capacity * 2));
+    Buffer* fresh = buffers.back().get();
+    for (int64_t i = t; i != b; ++i) {
+        fresh->Put(i, old->Get(i));
+    }
+    buffer.store(fresh, std::memory_order_release);
+    return fresh;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::Empty() const {
+    return !this->Size();
+}
+
+template<typename T>
+size_t WorkStealingDeque<T>::Size() const {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+}
+
+template<typename T>
+void WorkStealingDeque<T>::PushBack(const T& elem) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Buffer* a = buffer.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+        a = this->Grow(a, b, t);
+    }
+    a->Put(b, elem);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::PopBack(T* const value) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    T elem = a->Get(b);
+    if (t == b) {
+        // Last element: race the thieves for it through top.
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        if (!won) {
+            return false;
+        }
+    }
+    *value = elem;
+    return true;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::Steal(T* const value) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return false;
+    }
+    Buffer* a = buffer.load(std::memory_order_acquire);
+    T elem = a->Get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return false;
+    }
+    *value = elem;
+    return true;
+}
+
+int main() {
+    std::cout << "🧪 Тестирование WorkStealingDeque...\n";
+
+    // 1. Однопоточная семантика: владелец работает с концом как со стеком,
+    //    воры забирают с начала
+    WorkStealingDeque<int> d(2);
+    assert(d.Empty());
+    int value = 0;
+    [[maybe_unused]] bool got = d.PopBack(&value);
+    assert(!got);
+    got = d.Steal(&value);
+    assert(!got);
+    for (int i = 0; i < 10; ++i) {
+        d.PushBack(i);
+    }
+    assert(d.Size() == 10);
+    got = d.PopBack(&value);
+    assert(got && value == 9);
+    got = d.Steal(&value);
+    assert(got && value == 0);
+    got = d.Steal(&value);
+    assert(got && value == 1);
+    got = d.PopBack(&value);
+    assert(got && value == 8);
+    assert(d.Size() == 6);
+    while (d.PopBack(&value)) {
+    }
+    assert(d.Empty());
+    std::cout << "✅ PushBack/PopBack — LIFO, Steal — FIFO, буфер растёт с 2 до 16\n";
+
+    // 2. Стресс-тест: каждый элемент достаётся ровно одному потоку
+    const int kItems = 200000;
+    const unsigned max_thieves = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned thieves = 1; thieves <= max_thieves; ++thieves) {
+        WorkStealingDeque<int> wsd;
+        std::atomic<bool> done{false};
+        std::vector<std::vector<int>> taken(thieves + 1);
+        std::vector<std::thread> pool;
+        for (unsigned k = 1; k <= thieves; ++k) {
+            pool.emplace_back([&, k] {
+                int x;
+                while (!done.load(std::memory_order_acquire) || !wsd.Empty()) {
+                    if (wsd.Steal(&x)) {
+                        taken[k].push_back(x);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        int x;
+        for (int i = 0; i < kItems; ++i) {
+            wsd.PushBack(i);
+            if (i % 3 == 0 && wsd.PopBack(&x)) {
+                taken[0].push_back(x);
+            }
+        }
+        while (wsd.PopBack(&x)) {
+            taken[0].push_back(x);
+        }
+        done.store(true, std::memory_order_release);
+        for (auto& t : pool) {
+            t.join();
+        }
+        std::vector<int> seen(kItems, 0);
+        for (const auto& part : taken) {
+            for (int item : part) {
+                ++seen[item];
+            }
+        }
+        for ([[maybe_unused]] int cnt : seen) {
+            assert(cnt == 1);
+        }
+    }
+    std::cout << "✅ Стресс-тест: " << kItems << " задач, от 1 до " << max_thieves
+              << " воров — каждая задача выполнена ровно один раз\n";
+
+    // 3. Пропускная способность: владелец раздаёт задачи, воры их разбирают
+    std::cout << "\n⏱  Пропускная способность (задач в секунду):\n";
+    const int kBenchItems = 1000000;
+    for (unsigned thieves = 1; thieves <= max_thieves; ++thieves) {
+        WorkStealingDeque<int> wsd;
+        std::atomic<bool> done{false};
+        std::atomic<int64_t> processed{0};
+        std::vector<std::thread> pool;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned k = 0; k < thieves; ++k) {
+            pool.emplace_back([&] {
+                int x;
+                int64_t local = 0;
+                while (!done.load(std::memory_order_acquire) || !wsd.Empty()) {
+                    if (wsd.Steal(&x)) {
+                        ++local;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                processed.fetch_add(local);
+            });
+        }
+        int x;
+        int64_t local = 0;
+        for (int i = 0; i < kBenchItems; ++i) {
+            wsd.PushBack(i);
+            if (i % 2 == 0 && wsd.PopBack(&x)) {
+                ++local;
+            }
+        }
+        while (wsd.PopBack(&x)) {
+            ++local;
+        }
+        done.store(true, std::memory_order_release);
+        for (auto& t : pool) {
+            t.join();
+        }
+        processed.fetch_add(local);
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        assert(processed.load() == kBenchItems);
+        std::cout << "   воров: " << thieves << "  " << std::fixed << kBenchItems / dur.count() << '\n';
+    }
+
+    std::cout << "\n🎉 Все тесты пройдены!\n";
+    return 0;
+}